@@ -0,0 +1,28 @@
+#pragma once
+
+#include "inttypes.hpp"
+
+// Addresses of the 64 KB space that something wants to look at before
+// the instruction there runs: HLE entries, host hooks, breakpoints.
+// A run loop tests one bit per instruction and only looks further on a
+// marked address, so code without marks pays the same whatever is set
+// elsewhere. Marks are counted, each add() needs its own remove().
+class AddressMarks {
+public:
+    void add(u16 adr) {
+        if (_counts[adr]++ == 0) _bits[adr >> 5] |= 1u << (adr & 31);
+    }
+
+    void remove(u16 adr) {
+        if (_counts[adr] == 0) return;
+
+        if (--_counts[adr] == 0) _bits[adr >> 5] &= ~(1u << (adr & 31));
+    }
+
+    bool test(u16 adr) const { return (_bits[adr >> 5] >> (adr & 31)) & 1; }
+
+private:
+    // 8 KB, the only part the run loop reads
+    u32 _bits[0x10000 / 32] = {0};
+    u8  _counts[0x10000] = {0};
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+
+#include "bus.hpp"
+#include "cpu.hpp"
+
+// 36 KB, stored inline in every Dac. At most one OUT per 10 cycles
+// fills it in 20 ms at 2 MHz, the host drains it every few ms.
+#define ANALOG_TRACE_SIZE 4096
+
+// Cycle-stamped samples of an analog channel, kept as separate cycle and
+// value columns: 9 bytes per sample, and a consumer gets whole columns
+// it can hand to file or plotting code as they are.
+// Lock-free single producer / single consumer.
+class AnalogTrace {
+public:
+    // Producer side, false if the trace is full
+    bool push(u64 cycle, u8 value) {
+        u32 head = _head.load(std::memory_order_relaxed);
+
+        if (head - _tail.load(std::memory_order_acquire) == ANALOG_TRACE_SIZE) return false;
+
+        _cycles[head & (ANALOG_TRACE_SIZE - 1)] = cycle;
+        _values[head & (ANALOG_TRACE_SIZE - 1)] = value;
+        _head.store(head + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // Consumer side, moves up to `size` of the oldest samples into the
+    // columns and returns how many there were
+    u32 read(u64 *cycles, u8 *values, u32 size) {
+        u32 tail = _tail.load(std::memory_order_relaxed);
+        u32 count = _head.load(std::memory_order_acquire) - tail;
+
+        if (count > size) count = size;
+
+        for (u32 i = 0; i < count; i++) {
+            cycles[i] = _cycles[(tail + i) & (ANALOG_TRACE_SIZE - 1)];
+            values[i] = _values[(tail + i) & (ANALOG_TRACE_SIZE - 1)];
+        }
+
+        _tail.store(tail + count, std::memory_order_release);
+
+        return count;
+    }
+
+    u32 size() const {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+
+private:
+    u64 _cycles[ANALOG_TRACE_SIZE];
+    u8  _values[ANALOG_TRACE_SIZE];
+
+    char _padValues[64];
+    std::atomic<u32> _head{0};
+    char _padHead[64 - sizeof(std::atomic<u32>)];
+    std::atomic<u32> _tail{0};
+};
+
+// 8-bit DAC on an output port. Every write is traced with the cycle it
+// happened at, the host drains the trace on its own thread.
+class Dac : public BusDeviceWritable {
+public:
+    Dac(const Cpu &cpu) : _cpu(cpu) {}
+
+    void busPortWrite(u8 data) override {
+        _value = data;
+        _writes++;
+
+        if (!_trace.push(_cpu.getCycles(), data)) _dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    u8 getValue() const { return _value; }
+
+    // Writes made by the CPU, emulation thread only
+    u64 writes() const { return _writes; }
+
+    AnalogTrace &getTrace() { return _trace; }
+
+    // Writes lost while nobody drained the trace
+    u64 dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+    const Cpu &_cpu;
+
+    AnalogTrace _trace;
+    std::atomic<u64> _dropped{0};
+    u64 _writes = 0;
+    u8 _value = 0;
+};
+
+// Signal on the ADC input. Called on the emulation thread,
+// implementations must not block.
+class AnalogSource {
+public:
+    virtual ~AnalogSource() {}
+
+    virtual u8 analogSample(u64 cycle) = 0;
+};
+
+// 8-bit ADC on an input port: a read converts the input at the current
+// cycle, with no conversion delay. An unconnected input reads as 00h.
+class Adc : public BusDeviceReadable {
+public:
+    Adc(const Cpu &cpu) : _cpu(cpu) {}
+
+    u8 busPortRead() override {
+        return _source != nullptr ? _source->analogSample(_cpu.getCycles()) : 0x00;
+    }
+
+    void setSource(AnalogSource *source) { _source = source; }
+
+private:
+    const Cpu &_cpu;
+
+    AnalogSource *_source = nullptr;
+};
@@ -0,0 +1,202 @@
+#pragma once
+
+#include "addressmarks.hpp"
+#include "bus.hpp"
+#include "cpu.hpp"
+#include "expression.hpp"
+
+#define BREAKPOINTS_MAX             64
+
+struct Breakpoint {
+    int id = 0;
+    u16 address = 0;
+    bool enabled = true;
+
+    // Only reported to the listener, the run goes on
+    bool logOnly = false;
+
+    // Hits (passes with the condition true) it takes to act,
+    // it acts on that one and every one after it
+    u32 hitThreshold = 1;
+    u32 hits = 0;
+
+    // Empty - always
+    Expression condition;
+};
+
+class BreakpointListener {
+public:
+    // A log-only breakpoint acted, called on the emulating thread
+    virtual void breakpointLogged(const Breakpoint &breakpoint) = 0;
+};
+
+// Breakpoints kept in address order. Each one marks its address, so a
+// run loop only calls check() where a breakpoint (or another mark) is
+// and code without breakpoints runs at full speed however many there are.
+class Breakpoints {
+public:
+    Breakpoints(AddressMarks &marks, Cpu &cpu, Bus &bus) : _marks(marks), _view(cpu, bus) {}
+
+    // Returns the new breakpoint's id, 0 when the table is full
+    // or the condition doesn't compile (see Expression)
+    int add(u16 address, const char *condition = nullptr, u32 hitThreshold = 1,
+            bool logOnly = false) {
+        if (_count == BREAKPOINTS_MAX) return 0;
+
+        Breakpoint breakpoint;
+
+        if (!breakpoint.condition.compile(condition)) return 0;
+
+        breakpoint.id = _nextId++;
+        breakpoint.address = address;
+        breakpoint.hitThreshold = hitThreshold ? hitThreshold : 1;
+        breakpoint.logOnly = logOnly;
+
+        // After the ones already at the address
+        int i = _count;
+        for (; i > 0 && _list[i - 1].address > address; i--) _list[i] = _list[i - 1];
+
+        _list[i] = breakpoint;
+        _count++;
+
+        _marks.add(address);
+
+        return breakpoint.id;
+    }
+
+    bool remove(int id) {
+        int i = _indexOf(id);
+
+        if (i < 0) return false;
+
+        _marks.remove(_list[i].address);
+
+        for (_count--; i < _count; i++) _list[i] = _list[i + 1];
+
+        return true;
+    }
+
+    void clear() {
+        while (_count > 0) remove(_list[0].id);
+    }
+
+    bool setEnabled(int id, bool enabled) {
+        int i = _indexOf(id);
+
+        if (i < 0) return false;
+
+        _list[i].enabled = enabled;
+        return true;
+    }
+
+    void resetHits() {
+        for (int i = 0; i < _count; i++) _list[i].hits = 0;
+    }
+
+    const Breakpoint *find(int id) const {
+        int i = _indexOf(id);
+        return (i >= 0) ? &_list[i] : nullptr;
+    }
+
+    // In address order
+    int count() const { return _count; }
+    const Breakpoint &at(int i) const { return _list[i]; }
+
+    void setListener(BreakpointListener *listener) { _listener = listener; }
+
+    // Internal breakpoint of step over and run to, one at a time and not
+    // listed. It stops at `address` once SP is at or above `stackFloor`,
+    // so a deeper call of the routine being stepped over runs on, and is
+    // removed when it stops.
+    void setTemporary(u16 address, u16 stackFloor = 0) {
+        clearTemporary();
+
+        _temporary = true;
+        _temporaryAddress = address;
+        _temporaryFloor = stackFloor;
+
+        _marks.add(address);
+    }
+
+    void clearTemporary() {
+        if (!_temporary) return;
+
+        _marks.remove(_temporaryAddress);
+        _temporary = false;
+    }
+
+    bool hasTemporary() const { return _temporary; }
+
+    // Counts the hits of the breakpoints at `pc` before the instruction
+    // there runs, true when one of them stops the run. Only worth calling
+    // on a marked address.
+    bool check(u16 pc) {
+        bool stop = false;
+
+        for (int i = _lowerBound(pc); i < _count && _list[i].address == pc; i++) {
+            Breakpoint &breakpoint = _list[i];
+
+            if (!breakpoint.enabled || breakpoint.condition.evaluate(_view) == 0) continue;
+
+            if (++breakpoint.hits < breakpoint.hitThreshold) continue;
+
+            if (breakpoint.logOnly) {
+                if (_listener) _listener->breakpointLogged(breakpoint);
+            } else if (!stop) {
+                stop = true;
+                _stoppedBy = breakpoint.id;
+            }
+        }
+
+        if (_temporary && pc == _temporaryAddress && _view.sp() >= _temporaryFloor) {
+            clearTemporary();
+
+            if (!stop) {
+                stop = true;
+                _stoppedBy = 0;
+            }
+        }
+
+        return stop;
+    }
+
+    // Id of the breakpoint that stopped the last run, 0 - none yet
+    // or the temporary one
+    int stoppedBy() const { return _stoppedBy; }
+
+private:
+    AddressMarks &_marks;
+    CpuBusView _view;
+
+    Breakpoint _list[BREAKPOINTS_MAX];
+    int _count = 0;
+    int _nextId = 1;
+    int _stoppedBy = 0;
+
+    BreakpointListener *_listener = nullptr;
+
+    bool _temporary = false;
+    u16 _temporaryAddress = 0;
+    u16 _temporaryFloor = 0;
+
+    int _indexOf(int id) const {
+        for (int i = 0; i < _count; i++) {
+            if (_list[i].id == id) return i;
+        }
+
+        return -1;
+    }
+
+    int _lowerBound(u16 address) const {
+        int low = 0, high = _count;
+
+        while (low < high) {
+            int middle = (low + high) / 2;
+
+            if (_list[middle].address < address) low = middle + 1;
+            else high = middle;
+        }
+
+        return low;
+    }
+};
@@ -34,6 +34,21 @@ class Bus {
         const u8& romFirst() { return _memory[0]; }
         const u8& ramFirst() { return _memory[0x0800]; }
 
+        // Moves the address space into external storage of MEMORY_SIZE bytes
+        // (e.g. a memory-mapped file). RAM contents of the storage are kept,
+        // the ROM area is refreshed from the current image.
+        // Passing nullptr copies everything back to the internal storage.
+        void memoryAttach(u8* storage) {
+            u8* target = (storage != nullptr) ? storage : _storage;
+
+            if (target == _memory) return;
+
+            u64 size = (storage != nullptr) ? ROM_SIZE : MEMORY_SIZE;
+            for (u64 i = 0; i < size; target[i] = _memory[i], ++i);
+
+            _memory = target;
+        }
+
         void loadRom(const u8* buff, u64 size) {
             for (u64 i = 0; i < size; _memory[i] = buff[i], ++i);
         }
@@ -47,6 +62,8 @@ class Bus {
         }
 
         void portOut(u8 port, u8 data) {
+            _lastOut[port] = data;
+
             if (!_outDevices[port]) return;
 
             _outDevices[port]->busPortWrite(data);
@@ -56,13 +73,40 @@ class Bus {
             _inDevices[port] = &device;
         }
 
+        // Only while `device` still holds the port, so unmapping one
+        // device never disconnects another
+        void portUnbindOut(u8 port, const BusDeviceWritable& device) {
+            if (_outDevices[port] == &device) _outDevices[port] = nullptr;
+        }
+
+        void portUnbindIn(u8 port, const BusDeviceReadable& device) {
+            if (_inDevices[port] == &device) _inDevices[port] = nullptr;
+        }
+
+        bool isPortBoundOut(u8 port) const { return _outDevices[port] != nullptr; }
+        bool isPortBoundIn(u8 port) const  { return _inDevices[port] != nullptr; }
+
         u8 portIn(u8 port) {
-            return (_inDevices[port] != nullptr) ? _inDevices[port]->busPortRead() : 0x00;
+            u8 data = (_inDevices[port] != nullptr) ? _inDevices[port]->busPortRead() : 0x00;
+
+            _lastIn[port] = data;
+            return data;
         }
 
+        // Last bytes the CPU read from and wrote to a port, looked at
+        // without touching the device
+        u8 portLastIn(u8 port) const  { return _lastIn[port];  }
+        u8 portLastOut(u8 port) const { return _lastOut[port]; }
+        const u8* portsLastIn() const  { return _lastIn;  }
+        const u8* portsLastOut() const { return _lastOut; }
+
     private:
-        u8 _memory[MEMORY_SIZE]  = {0};
+        u8  _storage[MEMORY_SIZE] = {0};
+        u8* _memory = _storage;
 
         BusDeviceWritable*  _outDevices[PORTS_COUNT] = { nullptr };
         BusDeviceReadable*  _inDevices[PORTS_COUNT]  = { nullptr };
+
+        u8 _lastIn[PORTS_COUNT]  = {0};
+        u8 _lastOut[PORTS_COUNT] = {0};
 };
\ No newline at end of file
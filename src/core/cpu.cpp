@@ -5,6 +5,19 @@ Cpu::Cpu(Bus& bus) : _bus(bus) {
 }
 
 void Cpu::tick() {
+    if (_interruptRequests && _interruptsEnabled && !_enableInterrupts) {
+        int rstNum = 7;
+        while (!(_interruptRequests & (1 << rstNum))) rstNum--;
+
+        _interruptRequests &= ~(1 << rstNum);
+        _interruptsEnabled = false;
+        _hold              = false;
+
+        interruptRst(rstNum);
+        return;
+    }
+
+    _enableInterrupts = false;
     _readCommand();
 }
 
@@ -24,6 +37,7 @@ void Cpu::_readCommand(u8 opcode) {
     instructionFunction_t instruction = _instructions[opcode];
 
     _regCmd = opcode;
+    _cycles += _instructionCycles[opcode];
     _prgCounter++;
     _regAdr = _prgCounter;
 
@@ -2,6 +2,8 @@
 
 #include "bus.hpp"
 
+#define CPU_BRANCH_TAKEN_CYCLES 6
+
 struct CpuFlagsMapping { 
     u8 sign: 1,
             zero: 1, 
@@ -54,21 +56,58 @@ public:
     u8 getRegister(Register reg) const         { return _getRegData((u8)reg); }
     void    setRegister(Register reg, u8 data) { return _setRegData((u8)reg, data); }
 
+    // Emulated clock periods (states) since power on
+    u64  getCycles() const      { return _cycles;    }
+    void addCycles(u64 cycles)  { _cycles += cycles; }
+
     void interruptRst(int rstNum) {
-        if (rstNum < 8 && rstNum >= 0) _call(rstNum * 8, true);
+        if (rstNum < 8 && rstNum >= 0) {
+            _cycles += _instructionCycles[0xC7];
+            _call(rstNum * 8, true);
+        }
+    }
+
+    // INTR line. Requests are latched per RST number and taken before the
+    // next instruction once interrupts are enabled, the highest RST first
+    // (as with an 8214 priority encoder). The device supplies RST rstNum
+    // as the opcode and the taken request is cleared.
+    void requestInterrupt(int rstNum) {
+        if (rstNum >= 0 && rstNum < 8) _interruptRequests |= 1 << rstNum;
+    }
+
+    bool isInterruptPending() const     { return _interruptRequests != 0;    }
+    bool isInterruptPending(int rstNum) const {
+        return (_interruptRequests >> rstNum) & 1;
+    }
+    bool isInterruptsEnabled() const    { return _interruptsEnabled;         }
+
+    // Opcodes that push a return address: CALL, Ccc, RST and the
+    // undocumented CALL aliases DD, ED and FD
+    static bool isCallOpcode(u8 opcode) {
+        return (opcode & 0xCF) == 0xCD || (opcode & 0xC7) == 0xC4 || (opcode & 0xC7) == 0xC7;
+    }
+
+    // Opcodes that pop one: RET, Rcc and the undocumented RET alias D9
+    static bool isReturnOpcode(u8 opcode) {
+        return (opcode & 0xEF) == 0xC9 || (opcode & 0xC7) == 0xC0;
     }
 
     void forceCall(u16 adr) { _call(adr); }
     void forceJump(u16 adr) { _jmp(adr); }
+    void forceReturn()      { _ret(true); }
 
 private:
     Bus&        _bus;
 
+    // EI takes effect after the instruction that follows it
     bool        _enableInterrupts  = false;
+    u8          _interruptRequests = 0;
 
     bool        _hold              = false;
     bool        _interruptsEnabled = false;
 
+    u64    _cycles         = 0;
+
     u8     _regCmd         = 0x00;
     u16    _regAdr         = 0x0000;
     u16    _prgCounter     = 0x0000;
@@ -110,6 +149,29 @@ private:
         //  0x00         0x01         0x02         0x03         0x04         0x05         0x06         0x07         0x08         0x09         0x0A         0x0B         0x0C         0x0D         0x0E         0x0F        // 
     };
 
+    // States per instruction, conditional calls and returns add
+    // CPU_BRANCH_TAKEN_CYCLES when the branch is taken
+    const u8 _instructionCycles[256] = {
+        //  0x00 0x01 0x02 0x03 0x04 0x05 0x06 0x07 0x08 0x09 0x0A 0x0B 0x0C 0x0D 0x0E 0x0F //
+/* 0x00 */     4,  10,   7,   5,   5,   5,   7,   4,   4,  10,   7,   5,   5,   5,   7,   4, // 0x00
+/* 0x10 */     4,  10,   7,   5,   5,   5,   7,   4,   4,  10,   7,   5,   5,   5,   7,   4, // 0x10
+/* 0x20 */     4,  10,  16,   5,   5,   5,   7,   4,   4,  10,  16,   5,   5,   5,   7,   4, // 0x20
+/* 0x30 */     4,  10,  13,   5,  10,  10,  10,   4,   4,  10,  13,   5,   5,   5,   7,   4, // 0x30
+/* 0x40 */     5,   5,   5,   5,   5,   5,   7,   5,   5,   5,   5,   5,   5,   5,   7,   5, // 0x40
+/* 0x50 */     5,   5,   5,   5,   5,   5,   7,   5,   5,   5,   5,   5,   5,   5,   7,   5, // 0x50
+/* 0x60 */     5,   5,   5,   5,   5,   5,   7,   5,   5,   5,   5,   5,   5,   5,   7,   5, // 0x60
+/* 0x70 */     7,   7,   7,   7,   7,   7,   7,   7,   5,   5,   5,   5,   5,   5,   7,   5, // 0x70
+/* 0x80 */     4,   4,   4,   4,   4,   4,   7,   4,   4,   4,   4,   4,   4,   4,   7,   4, // 0x80
+/* 0x90 */     4,   4,   4,   4,   4,   4,   7,   4,   4,   4,   4,   4,   4,   4,   7,   4, // 0x90
+/* 0xA0 */     4,   4,   4,   4,   4,   4,   7,   4,   4,   4,   4,   4,   4,   4,   7,   4, // 0xA0
+/* 0xB0 */     4,   4,   4,   4,   4,   4,   7,   4,   4,   4,   4,   4,   4,   4,   7,   4, // 0xB0
+/* 0xC0 */     5,  10,  10,  10,  11,  11,   7,  11,   5,  10,  10,  10,  11,  17,   7,  11, // 0xC0
+/* 0xD0 */     5,  10,  10,  10,  11,  11,   7,  11,   5,  10,  10,  10,  11,  17,   7,  11, // 0xD0
+/* 0xE0 */     5,  10,  10,  18,  11,  11,   7,  11,   5,   5,  10,   4,  11,  17,   7,  11, // 0xE0
+/* 0xF0 */     5,  10,  10,   4,  11,  11,   7,  11,   5,   5,  10,   4,  11,  17,   7,  11, // 0xF0
+        //  0x00 0x01 0x02 0x03 0x04 0x05 0x06 0x07 0x08 0x09 0x0A 0x0B 0x0C 0x0D 0x0E 0x0F //
+    };
+
     // Machine cycles
     void        _readCommand();
     void        _readCommand(u8 opcode);
@@ -218,6 +280,7 @@ private:
     void _call(u16 adr, bool cond = true);
     void _call(bool cond = true);
     void _call();
+    void _callIf(bool cond);
     void _cc();
     void _cnc();
     void _cz();
@@ -230,6 +293,7 @@ private:
     // Return instructions 
     void _ret(bool cond = true);
     void _ret();
+    void _retIf(bool cond);
     void _rc();
     void _rnc();
     void _rz();
@@ -498,15 +498,21 @@ void Cpu::_call(bool cond) {
     _call(adr, cond);
 }
 
-void Cpu::_call()   { _call(true);                  }
-void Cpu::_cc()     { _call(_regFlag.carry == 0b1); }
-void Cpu::_cnc()    { _call(_regFlag.carry == 0b0); }
-void Cpu::_cz()     { _call(_regFlag.zero  == 0b1); }
-void Cpu::_cnz()    { _call(_regFlag.zero  == 0b0); }
-void Cpu::_cm()     { _call(_regFlag.sign  == 0b1); }
-void Cpu::_cp()     { _call(_regFlag.sign  == 0b0); }
-void Cpu::_cpe()    { _call(_regFlag.parity == 0b1); }
-void Cpu::_cpo()    { _call(_regFlag.parity == 0b0); }
+void Cpu::_callIf(bool cond) {
+    if (cond) _cycles += CPU_BRANCH_TAKEN_CYCLES;
+
+    _call(cond);
+}
+
+void Cpu::_call()   { _call(true);                    }
+void Cpu::_cc()     { _callIf(_regFlag.carry == 0b1); }
+void Cpu::_cnc()    { _callIf(_regFlag.carry == 0b0); }
+void Cpu::_cz()     { _callIf(_regFlag.zero  == 0b1); }
+void Cpu::_cnz()    { _callIf(_regFlag.zero  == 0b0); }
+void Cpu::_cm()     { _callIf(_regFlag.sign  == 0b1); }
+void Cpu::_cp()     { _callIf(_regFlag.sign  == 0b0); }
+void Cpu::_cpe()    { _callIf(_regFlag.parity == 0b1); }
+void Cpu::_cpo()    { _callIf(_regFlag.parity == 0b0); }
 
 // Return instructions 
 void Cpu::_ret(bool cond) { 
@@ -516,15 +522,21 @@ void Cpu::_ret(bool cond) {
     _prgCounter = adr;
 }
 
-void Cpu::_ret() { _ret(true);                  }
-void Cpu::_rc()  { _ret(_regFlag.carry == 0b1); }
-void Cpu::_rnc() { _ret(_regFlag.carry == 0b0); }
-void Cpu::_rz()  { _ret(_regFlag.zero  == 0b1); }
-void Cpu::_rnz() { _ret(_regFlag.zero  == 0b0); }
-void Cpu::_rm()  { _ret(_regFlag.sign  == 0b1); }
-void Cpu::_rp()  { _ret(_regFlag.sign  == 0b0); }
-void Cpu::_rpe() { _ret(_regFlag.parity == 0b1); }
-void Cpu::_rpo() { _ret(_regFlag.parity == 0b0); }
+void Cpu::_retIf(bool cond) {
+    if (cond) _cycles += CPU_BRANCH_TAKEN_CYCLES;
+
+    _ret(cond);
+}
+
+void Cpu::_ret() { _ret(true);                    }
+void Cpu::_rc()  { _retIf(_regFlag.carry == 0b1); }
+void Cpu::_rnc() { _retIf(_regFlag.carry == 0b0); }
+void Cpu::_rz()  { _retIf(_regFlag.zero  == 0b1); }
+void Cpu::_rnz() { _retIf(_regFlag.zero  == 0b0); }
+void Cpu::_rm()  { _retIf(_regFlag.sign  == 0b1); }
+void Cpu::_rp()  { _retIf(_regFlag.sign  == 0b0); }
+void Cpu::_rpe() { _retIf(_regFlag.parity == 0b1); }
+void Cpu::_rpo() { _retIf(_regFlag.parity == 0b0); }
 
 // Rst instruction
 void Cpu::_rst() { 
@@ -536,7 +548,7 @@ void Cpu::_rst() {
 }
 
 // Interrupt Flip-Flop instructions
-void Cpu::_ei() { _interruptsEnabled = true; }
+void Cpu::_ei() { _interruptsEnabled = true; _enableInterrupts = true; }
 void Cpu::_di() { _interruptsEnabled = false; }
 
 // IO instructions
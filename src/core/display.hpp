@@ -1,9 +1,15 @@
 #pragma once
 
 #include "bus.hpp"
+#include "cpu.hpp"
+
+// 40 ms of afterglow at the 2 MHz clock
+#define DISPLAY_PERSISTENCE_CYCLES 80000
 
 class Display : public BusDeviceWritable {
 public:
+    Display(const Cpu& cpu) : _cpu(cpu) {}
+
     void busPortWrite(u8 data) { _lastSegmentValue = data; }
 
     void lightup(u8 digitValue) {
@@ -25,23 +31,36 @@ public:
             return;
 
         _digits[digit] = _lastSegmentValue;
+        _refreshCycles[digit] = _cpu.getCycles();
+    }
+
+    // Segments of the digit, or 0x00 if it wasn't refreshed
+    // within the persistence time
+    u8 get(u8 digit) const {
+        if (_cpu.getCycles() - _refreshCycles[digit] > _persistence)
+            return 0x00;
 
-        _lightoffTimer = 255;
+        return _digits[digit];
     }
 
-    u8 get(u8 digit) {
-        _lightoffTimer--;
+    // 255 right after a refresh, fading linearly to 0 at the persistence time
+    u8 getBrightness(u8 digit) const {
+        u64 age = _cpu.getCycles() - _refreshCycles[digit];
 
-        if (_lightoffTimer <= 0) {
-            _lightoffTimer = 0;
-            return 0x00;
-        }
+        if (age > _persistence)
+            return 0;
+
+        return (u8)(255 - (age * 255) / _persistence);
+    }
 
-        return _digits[digit]; 
-    };
+    void setPersistence(u32 cycles) { _persistence = (cycles > 0) ? cycles : 1; }
+    u32 getPersistence() const { return _persistence; }
 
 private:
-    u8 _digits[6] = {0};
-    u8 _lastSegmentValue = 0x00;
-    int _lightoffTimer = 0;
-};
\ No newline at end of file
+    const Cpu& _cpu;
+
+    u8  _digits[6] = {0};
+    u64 _refreshCycles[6] = {0};
+    u8  _lastSegmentValue = 0x00;
+    u32 _persistence = DISPLAY_PERSISTENCE_CYCLES;
+};
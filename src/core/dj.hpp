@@ -3,38 +3,97 @@
 #include <SFML/Audio.hpp>
 #include <cmath>
 
+#include "ring.hpp"
+
 #define TWOPI 6.283185307
 
-class Dj {
+// Plays the tones of the monitor's sound subroutine.
+// tone() only queues the note, the samples are produced on the
+// SFML audio thread from the phase within the note's square wave
+// period, with no tables or allocations there.
+class Dj : private sf::SoundStream {
 public:
+    // `onAudioThread` is called once on the audio thread before the
+    // first samples, to set the thread up
+    Dj(void (*onAudioThread)() = nullptr) : _onAudioThread(onAudioThread) {
+        initialize(1, SAMPLE_RATE);
+        setVolume(10);
+        play();
+    }
+
+    ~Dj() { stop(); }
+
+    // Never blocks, a note that doesn't fit in the queue is dropped
     void tone(double freq, int duration) {
-        for (int i = 0; i < duration; i++) {
-            _samples.push_back(_squareWave(i, freq, 0.7));
+        _tones.push({freq, duration});
+    }
+
+private:
+    static const unsigned SAMPLE_RATE = 44100;
+    static const unsigned CHUNK_SAMPLES = 1024;
+
+    struct Tone {
+        double freq;
+        int duration;
+    };
+
+    SpscRing<Tone, 256> _tones;
+
+    void (*_onAudioThread)();
+
+    // Audio thread state
+    bool _threadSetUp = false;
+    double _freq = 0;
+    int _periodSamples = 1;
+    int _remaining = 0;
+    int _phase = 0;
+    sf::Int16 _samples[CHUNK_SAMPLES];
+
+    bool onGetData(Chunk& data) override {
+        if (!_threadSetUp) {
+            if (_onAudioThread != nullptr) _onAudioThread();
+            _threadSetUp = true;
         }
 
-        _sndBuffer.loadFromSamples(&_samples[0], _samples.size(), 1, 44100);
-        _sound.setBuffer(_sndBuffer);
-        _sound.setVolume(10);
-        _sound.play();
+        for (unsigned i = 0; i < CHUNK_SAMPLES; i++) {
+            if (_remaining == 0) _nextTone();
 
-        while (_sound.getStatus() == _sound.Playing)
-            ;
+            if (_remaining > 0) {
+                _samples[i] = _squareWave(_phase, _freq, 0.7);
+                if (++_phase >= _periodSamples) _phase = 0;
+                _remaining--;
+            } else {
+                _samples[i] = 0;
+            }
+        }
 
-        _samples.clear();
-        _sound.resetBuffer();
+        // Silence keeps the stream alive between notes
+        data.samples = _samples;
+        data.sampleCount = CHUNK_SAMPLES;
+
+        return true;
     }
 
-private:
-    sf::SoundBuffer _sndBuffer;
-    std::vector<sf::Int16> _samples;
-    sf::Sound _sound;
+    void onSeek(sf::Time) override {}
+
+    void _nextTone() {
+        Tone tone;
+
+        if (!_tones.pop(tone)) return;
+
+        // Above half the sample rate there is nothing to play
+        _freq = (tone.freq > 0 && tone.freq <= SAMPLE_RATE / 2) ? tone.freq : 0;
+        _periodSamples = (_freq > 0) ? (int)(SAMPLE_RATE / _freq) : 1;
+        _remaining = tone.duration;
+        _phase = 0;
+    }
 
     short _squareWave(double time, double freq, double amp) {
         if (freq == 0)
             return 0;
 
         short result = 0;
-        int tpc = 44100 / freq;
+        int tpc = SAMPLE_RATE / freq;
         int cyclepart = int(time) % tpc;
         int halfcycle = tpc / 2;
         short amplitude = 32767 * amp;
@@ -49,7 +108,7 @@ private:
     short _sineWave(double time, double freq, double amp) {
         short result;
 
-        double tpc = 44100 / freq;
+        double tpc = SAMPLE_RATE / freq;
         double cycles = time / tpc;
         double rad = TWOPI * cycles;
         short amplitude = 32767 * amp;
@@ -57,4 +116,4 @@ private:
 
         return result;
     }
-};
\ No newline at end of file
+};
@@ -0,0 +1,494 @@
+#pragma once
+
+#include "bus.hpp"
+#include "cpu.hpp"
+
+#define EXPRESSION_TEXT_SIZE    96
+#define EXPRESSION_CODE_SIZE    96
+#define EXPRESSION_STACK_SIZE   16
+
+// Expression over the machine state for breakpoint conditions and
+// watches, e.g. "A == 3F && [0BF0] != 0". It is compiled once into a
+// compact stack bytecode, so evaluating it on every pass of a tight
+// loop takes a few nanoseconds, with no recursion or allocation.
+//
+// Operands:
+//   A B C D E H L M         registers, M is the byte at HL
+//   BC DE HL SP PC          register pairs
+//   S Z AC P CY             flags, 0 or 1
+//   CYCLES                  emulated states since power on
+//   [<expr>] W[<expr>]      memory byte and little-endian word
+//   IN[<expr>] OUT[<expr>]  last byte read from and written to a port
+//   numbers                 hex starting with a digit (0FFh, 0x3F, 10)
+// Operators, with C precedence, on unsigned 64-bit values (x / 0 is 0):
+//   ! ~ -  * / %  + -  << >>  < <= > >=  == !=  &  ^  |  &&  ||
+//
+// A machine is read through a view with reg(Cpu::Register), sp(), pc(),
+// flags(), cycles(), memory(adr), portIn(port) and portOut(port), see
+// CpuBusView.
+class Expression {
+public:
+    Expression() { compile(nullptr); }
+
+    // Empty or nullptr compiles to an expression that is always 1.
+    // False on a syntax error or an expression too long, the previous
+    // one is kept then.
+    bool compile(const char *text) {
+        Compiler compiler;
+        compiler.p = text ? text : "";
+
+        compiler.skipSpaces();
+
+        if (*compiler.p == 0) {
+            compiler.emit(PUSH_BYTE);
+            compiler.emit(1);
+            compiler.push();
+        } else if (!compiler.binary(0) || (compiler.skipSpaces(), *compiler.p != 0)) {
+            return false;
+        }
+
+        compiler.emit(RETURN);
+
+        int length = 0;
+        while (text && text[length]) length++;
+
+        if (!compiler.ok || length >= EXPRESSION_TEXT_SIZE) return false;
+
+        for (int i = 0; i < compiler.length; i++) _code[i] = compiler.code[i];
+        for (int i = 0; i <= length; i++) _text[i] = text ? text[i] : 0;
+
+        _codeSize = (u8)compiler.length;
+
+        return true;
+    }
+
+    bool empty() const { return _text[0] == 0; }
+    const char *text() const { return _text; }
+    int codeSize() const { return _codeSize; }
+
+    template <class Machine>
+    u64 evaluate(Machine &machine) const {
+        u64 stack[EXPRESSION_STACK_SIZE];
+        u64 *top = stack - 1;
+        const u8 *ip = _code;
+
+        for (;;) {
+            switch (*ip++) {
+            case PUSH_BYTE: *++top = ip[0]; ip += 1; break;
+            case PUSH_WORD: *++top = ip[0] | (u16)ip[1] << 8; ip += 2; break;
+            case PUSH_LONG: {
+                u64 value = 0;
+                for (int i = 7; i >= 0; i--) value = value << 8 | ip[i];
+                *++top = value;
+                ip += 8;
+                break;
+            }
+
+            case REGISTER: *++top = machine.reg((Cpu::Register)*ip++); break;
+            case PAIR:     *++top = _pair(machine, *ip++); break;
+            case FLAG:     *++top = _flag(machine.flags(), *ip++); break;
+            case CYCLES:   *++top = machine.cycles(); break;
+
+            case BYTE_AT:  *++top = machine.memory(ip[0] | (u16)ip[1] << 8); ip += 2; break;
+            case WORD_AT:  *++top = _word(machine, ip[0] | (u16)ip[1] << 8); ip += 2; break;
+            case BYTE:     *top = machine.memory((u16)*top); break;
+            case WORD:     *top = _word(machine, (u16)*top); break;
+            case PORT_IN:  *top = machine.portIn((u8)*top); break;
+            case PORT_OUT: *top = machine.portOut((u8)*top); break;
+
+            case NOT:   *top = !*top; break;
+            case COMPL: *top = ~*top; break;
+            case NEG:   *top = 0 - *top; break;
+            case BOOL:  *top = *top != 0; break;
+
+            case MUL: top--; top[0] *= top[1]; break;
+            case DIV: top--; top[0] = top[1] ? top[0] / top[1] : 0; break;
+            case MOD: top--; top[0] = top[1] ? top[0] % top[1] : 0; break;
+            case ADD: top--; top[0] += top[1]; break;
+            case SUB: top--; top[0] -= top[1]; break;
+            case SHL: top--; top[0] = top[1] < 64 ? top[0] << top[1] : 0; break;
+            case SHR: top--; top[0] = top[1] < 64 ? top[0] >> top[1] : 0; break;
+            case LT:  top--; top[0] = top[0] <  top[1]; break;
+            case LE:  top--; top[0] = top[0] <= top[1]; break;
+            case GT:  top--; top[0] = top[0] >  top[1]; break;
+            case GE:  top--; top[0] = top[0] >= top[1]; break;
+            case EQ:  top--; top[0] = top[0] == top[1]; break;
+            case NE:  top--; top[0] = top[0] != top[1]; break;
+            case AND: top--; top[0] &= top[1]; break;
+            case XOR: top--; top[0] ^= top[1]; break;
+            case OR:  top--; top[0] |= top[1]; break;
+
+            // Short circuits: the left value decides, or is dropped
+            case AND_JUMP:
+                if (*top == 0) ip = _code + *ip;
+                else top--, ip++;
+                break;
+            case OR_JUMP:
+                if (*top != 0) *top = 1, ip = _code + *ip;
+                else top--, ip++;
+                break;
+
+            default: return *top;
+            }
+        }
+    }
+
+private:
+    enum Op : u8 {
+        RETURN,
+        PUSH_BYTE, PUSH_WORD, PUSH_LONG,
+        REGISTER, PAIR, FLAG, CYCLES,
+        BYTE_AT, WORD_AT, BYTE, WORD, PORT_IN, PORT_OUT,
+        NOT, COMPL, NEG, BOOL,
+        MUL, DIV, MOD, ADD, SUB, SHL, SHR,
+        LT, LE, GT, GE, EQ, NE,
+        AND, XOR, OR,
+        AND_JUMP, OR_JUMP,
+    };
+
+    enum Pair : u8 { PAIR_BC, PAIR_DE, PAIR_HL, PAIR_SP, PAIR_PC };
+    enum Flag : u8 { FLAG_S, FLAG_Z, FLAG_AC, FLAG_P, FLAG_CY };
+
+    char _text[EXPRESSION_TEXT_SIZE] = {0};
+    u8 _code[EXPRESSION_CODE_SIZE] = {0};
+    u8 _codeSize = 0;
+
+    template <class Machine>
+    static u64 _pair(Machine &machine, u8 pair) {
+        switch (pair) {
+        case PAIR_SP: return machine.sp();
+        case PAIR_PC: return machine.pc();
+        default:
+            return (u16)machine.reg((Cpu::Register)(pair * 2)) << 8 |
+                   machine.reg((Cpu::Register)(pair * 2 + 1));
+        }
+    }
+
+    static u64 _flag(CpuFlagsMapping flags, u8 flag) {
+        switch (flag) {
+        case FLAG_S:  return flags.sign;
+        case FLAG_Z:  return flags.zero;
+        case FLAG_AC: return flags.auxcarry;
+        case FLAG_P:  return flags.parity;
+        default:      return flags.carry;
+        }
+    }
+
+    template <class Machine>
+    static u64 _word(Machine &machine, u16 adr) {
+        return machine.memory(adr) | (u16)machine.memory((u16)(adr + 1)) << 8;
+    }
+
+    // Recursive descent, one level per C precedence level
+    struct Compiler {
+        const char *p = "";
+        u8 code[EXPRESSION_CODE_SIZE];
+        int length = 0;
+        int depth = 0;
+        bool ok = true;
+
+        // Where the last constant was pushed and its value, an operand
+        // that turns out to be just a constant is folded into the
+        // instruction that uses it
+        int constantAt = -1;
+        u64 constant = 0;
+
+        void emit(u8 byte) {
+            if (length == EXPRESSION_CODE_SIZE) {
+                ok = false;
+                return;
+            }
+
+            code[length++] = byte;
+        }
+
+        void emitWord(u16 word) {
+            emit(word & 0xFF);
+            emit(word >> 8);
+        }
+
+        void push() {
+            if (++depth > EXPRESSION_STACK_SIZE) ok = false;
+        }
+
+        void skipSpaces() {
+            while (*p == ' ' || *p == '\t') p++;
+        }
+
+        static char upper(char c) { return (c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c; }
+        static bool isName(char c) {
+            c = upper(c);
+            return (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+        }
+
+        static int hexDigit(char c) {
+            c = upper(c);
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
+
+        // True if `text` is next, a name only as a whole word
+        bool accept(const char *text) {
+            const char *q = p;
+
+            skipSpaces();
+            const char *start = p;
+
+            for (; *text; text++, p++) {
+                if (upper(*p) != *text) {
+                    p = q;
+                    return false;
+                }
+            }
+
+            if (isName(*start) && isName(*p)) {
+                p = q;
+                return false;
+            }
+
+            return true;
+        }
+
+        // `text` next, but not followed by one of `excluded`
+        bool acceptOperator(const char *text, const char *excluded) {
+            const char *q = p;
+
+            if (!accept(text)) return false;
+
+            for (; *excluded; excluded++) {
+                if (*p == *excluded) {
+                    p = q;
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        void pushConstant(u64 value) {
+            constantAt = length;
+            constant = value;
+
+            if (value <= 0xFF) {
+                emit(PUSH_BYTE);
+                emit((u8)value);
+            } else if (value <= 0xFFFF) {
+                emit(PUSH_WORD);
+                emitWord((u16)value);
+            } else {
+                emit(PUSH_LONG);
+                for (int i = 0; i < 8; i++) emit((u8)(value >> (i * 8)));
+            }
+
+            push();
+        }
+
+        bool number() {
+            u64 value = 0;
+            int digits = 0;
+
+            if (p[0] == '0' && upper(p[1]) == 'X') p += 2;
+
+            for (; hexDigit(*p) >= 0; p++, digits++) {
+                if (value >> 60) return false;
+                value = value << 4 | hexDigit(*p);
+            }
+
+            if (upper(*p) == 'H') p++;
+            if (digits == 0 || isName(*p)) return false;
+
+            pushConstant(value);
+            return true;
+        }
+
+        // "[<expr>]" of a memory or port operand. A constant memory
+        // address is folded into `folded`, RETURN - never folded.
+        bool bracket(Op indirect, Op folded) {
+            skipSpaces();
+            if (*p++ != '[') return false;
+
+            int start = length;
+
+            if (!binary(0)) return false;
+
+            skipSpaces();
+            if (*p++ != ']') return false;
+
+            if (folded != RETURN && constantAt == start && constant <= 0xFFFF) {
+                length = start;
+                emit(folded);
+                emitWord((u16)constant);
+            } else {
+                emit(indirect);
+            }
+
+            constantAt = -1;
+            return true;
+        }
+
+        bool primary() {
+            static const struct { const char *name; Op op; u8 operand; } names[] = {
+                {"CYCLES", CYCLES,   0},
+                {"BC",     PAIR,     PAIR_BC},
+                {"DE",     PAIR,     PAIR_DE},
+                {"HL",     PAIR,     PAIR_HL},
+                {"SP",     PAIR,     PAIR_SP},
+                {"PC",     PAIR,     PAIR_PC},
+                {"AC",     FLAG,     FLAG_AC},
+                {"CY",     FLAG,     FLAG_CY},
+                {"S",      FLAG,     FLAG_S},
+                {"Z",      FLAG,     FLAG_Z},
+                {"P",      FLAG,     FLAG_P},
+                {"A",      REGISTER, (u8)Cpu::Register::A},
+                {"B",      REGISTER, (u8)Cpu::Register::B},
+                {"C",      REGISTER, (u8)Cpu::Register::C},
+                {"D",      REGISTER, (u8)Cpu::Register::D},
+                {"E",      REGISTER, (u8)Cpu::Register::E},
+                {"H",      REGISTER, (u8)Cpu::Register::H},
+                {"L",      REGISTER, (u8)Cpu::Register::L},
+                {"M",      REGISTER, (u8)Cpu::Register::M},
+            };
+
+            skipSpaces();
+
+            if (*p >= '0' && *p <= '9') return number();
+
+            if (*p == '(') {
+                p++;
+                if (!binary(0)) return false;
+
+                skipSpaces();
+                if (*p++ != ')') return false;
+
+                // Still a lone constant when it was one
+                return true;
+            }
+
+            if (*p == '[') return bracket(BYTE, BYTE_AT);
+            if (accept("W")) return bracket(WORD, WORD_AT);
+            if (accept("IN")) return bracket(PORT_IN, RETURN);
+            if (accept("OUT")) return bracket(PORT_OUT, RETURN);
+
+            for (unsigned i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+                if (!accept(names[i].name)) continue;
+
+                constantAt = -1;
+                emit(names[i].op);
+                if (names[i].op != CYCLES) emit(names[i].operand);
+                push();
+                return true;
+            }
+
+            return false;
+        }
+
+        bool unary() {
+            Op op;
+
+            if (acceptOperator("!", "=")) op = NOT;
+            else if (accept("~")) op = COMPL;
+            else if (accept("-")) op = NEG;
+            else return primary();
+
+            if (!unary()) return false;
+
+            constantAt = -1;
+            emit(op);
+            return true;
+        }
+
+        // Binary operators from the loosest level, `&&` and `||`
+        // short-circuit
+        bool binary(int level) {
+            if (level == LEVELS) return unary();
+
+            if (!binary(level + 1)) return false;
+
+            for (;;) {
+                Op op;
+
+                if (!matchOperator(level, op)) return true;
+
+                constantAt = -1;
+
+                if (op == AND_JUMP || op == OR_JUMP) {
+                    emit(op);
+                    int target = length;
+                    emit(0);
+                    depth--;
+
+                    if (!binary(level + 1)) return false;
+
+                    emit(BOOL);
+                    if (ok) code[target] = (u8)length;
+                } else {
+                    if (!binary(level + 1)) return false;
+
+                    emit(op);
+                    depth--;
+                }
+
+                constantAt = -1;
+            }
+        }
+
+        static const int LEVELS = 10;
+
+        bool matchOperator(int level, Op &op) {
+            // Longer ones first, "<" must not take the start of "<<"
+            static const struct { int level; const char *text; const char *excluded; Op op; }
+            operators[] = {
+                {0, "||", "",  OR_JUMP},
+                {1, "&&", "",  AND_JUMP},
+                {2, "|",  "|", OR},
+                {3, "^",  "",  XOR},
+                {4, "&",  "&", AND},
+                {5, "==", "",  EQ},
+                {5, "!=", "",  NE},
+                {6, "<=", "",  LE},
+                {6, ">=", "",  GE},
+                {6, "<",  "<", LT},
+                {6, ">",  ">", GT},
+                {7, "<<", "",  SHL},
+                {7, ">>", "",  SHR},
+                {8, "+",  "",  ADD},
+                {8, "-",  "",  SUB},
+                {9, "*",  "",  MUL},
+                {9, "/",  "",  DIV},
+                {9, "%",  "",  MOD},
+            };
+
+            for (unsigned i = 0; i < sizeof(operators) / sizeof(operators[0]); i++) {
+                if (operators[i].level != level) continue;
+
+                if (acceptOperator(operators[i].text, operators[i].excluded)) {
+                    op = operators[i].op;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+    };
+};
+
+// The machine as an expression reads it, straight off the CPU and the bus
+class CpuBusView {
+public:
+    CpuBusView(Cpu &cpu, Bus &bus) : _cpu(cpu), _bus(bus) {}
+
+    u8 reg(Cpu::Register reg) { return _cpu.getRegister(reg); }
+    u16 sp() { return _cpu.getStackPointer(); }
+    u16 pc() { return _cpu.getProgramCounter(); }
+    CpuFlagsMapping flags() { return _cpu.getFlags(); }
+    u64 cycles() { return _cpu.getCycles(); }
+
+    u8 memory(u16 adr) { return _bus.memoryRead(adr); }
+    u8 portIn(u8 port) { return _bus.portLastIn(port); }
+    u8 portOut(u8 port) { return _bus.portLastOut(port); }
+
+private:
+    Cpu &_cpu;
+    Bus &_bus;
+};
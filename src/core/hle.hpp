@@ -0,0 +1,35 @@
+#pragma once
+
+#include "inttypes.hpp"
+
+// Monitor routines that can run at a high level: when the CPU reaches
+// the entry of an enabled routine, its handler does the routine's work
+// at once, leaving registers, memory and the cycle count as the ROM code
+// would, and returns. Each one can be switched back to the ROM code to
+// compare the two.
+enum class HleRoutine : u8 {
+    DisplayScan,    // 01C8h, one-time screen scan
+    Delay1ms,       // 0429h, fixed 1 ms delay
+    Delay,          // 0430h, BC ms delay
+    Multiply,       // 04E1h, BC = D * E
+    DecodeMessage,  // 01E9h, 0BF0h-0BF5h to seven-segment codes and a scan
+
+    Count
+};
+
+struct HleRoutineInfo {
+    u16 address;
+    const char *name;
+};
+
+inline const HleRoutineInfo &hleRoutineInfo(HleRoutine routine) {
+    static const HleRoutineInfo routines[(int)HleRoutine::Count] = {
+        {0x01C8, "scan"},
+        {0x0429, "delay1ms"},
+        {0x0430, "delay"},
+        {0x04E1, "multiply"},
+        {0x01E9, "decode"},
+    };
+
+    return routines[(int)routine];
+}
@@ -0,0 +1,369 @@
+#pragma once
+
+#include "bus.hpp"
+#include "cpu.hpp"
+#include "scheduler.hpp"
+
+#define PPI_PORT_A 0
+#define PPI_PORT_B 1
+#define PPI_PORT_C 2
+
+// Notified only when the pins of a port change, with the packed byte
+// as seen from outside (outputs, handshake lines and external inputs)
+class PpiListener {
+public:
+    virtual void ppiPortChanged(u8 port, u64 cycle, u8 pins) = 0;
+};
+
+// KR580VV55 (Intel 8255) parallel interface, ports A, B, C at base..base+2
+// and the control word at base+3. Supports modes 0, 1 and 2 and the
+// port C bit set/reset command.
+// The peripheral side is driven by host code: input pins, strobes and
+// acknowledges. Delayed strobes and automatic acknowledges are scheduler
+// events, so the emulation loop does nothing while the PPI is idle.
+class Ppi8255 : public SchedulerClient {
+public:
+    Ppi8255(Cpu &cpu, Scheduler &scheduler)
+        : _cpu(cpu), _scheduler(scheduler),
+          _ports{{*this, 0}, {*this, 1}, {*this, 2}, {*this, 3}} {}
+
+    void bind(Bus &bus, u8 basePort) {
+        for (int i = 0; i < 4; i++) {
+            bus.portBindIn(basePort + i, _ports[i]);
+            bus.portBindOut(basePort + i, _ports[i]);
+        }
+    }
+
+    void unbind(Bus &bus, u8 basePort) {
+        for (int i = 0; i < 4; i++) {
+            bus.portUnbindIn(basePort + i, _ports[i]);
+            bus.portUnbindOut(basePort + i, _ports[i]);
+        }
+    }
+
+    void setListener(PpiListener *listener) {
+        _listener = listener;
+
+        for (u8 port = 0; port < 3; port++) _reported[port] = getPins(port);
+    }
+
+    // INTR of port A or B raises RST `rstNum`, -1 disconnects
+    void setInterrupt(u8 port, int rstNum) { _rst[port & 1] = rstNum; }
+
+    // Packed pin state of a port
+    u8 getPins(u8 port) const {
+        switch (port) {
+        case PPI_PORT_A: return _isOutput(PPI_PORT_A) ? _out[0] : _ext[0];
+        case PPI_PORT_B: return _isOutput(PPI_PORT_B) ? _out[1] : _ext[1];
+        default:         return _pinsC();
+        }
+    }
+
+    // Levels the peripheral drives onto the input pins
+    void setInput(u8 port, u8 value) {
+        _ext[port % 3] = value;
+        _notify();
+    }
+
+    // Peripheral strobes `data` into the input latch of port A or B
+    // (mode 1 input or mode 2), `delay` cycles from now
+    void strobe(u8 port, u8 data, u64 delay = 0) {
+        port &= 1;
+
+        if (delay == 0) {
+            _strobe(port, data);
+        } else {
+            _strobeData[port] = data;
+            _scheduler.post(_cpu.getCycles() + delay, *this, EVENT_STROBE + port);
+        }
+    }
+
+    // Peripheral took the byte from the output latch of port A or B
+    void acknowledge(u8 port) {
+        port &= 1;
+
+        if (!_obf[port]) return;
+
+        _obf[port] = false;
+        _requestIntr(port, _inteBit(port, true));
+        _notify();
+    }
+
+    // Acknowledge every output handshake `cycles` after the CPU writes
+    // the port, 0 leaves it to acknowledge()
+    void setAutoAcknowledge(u8 port, u32 cycles) { _autoAck[port & 1] = cycles; }
+
+    void reset() {
+        for (int i = 0; i < 4; i++) _scheduler.cancel(*this, i);
+
+        _control = CONTROL_RESET;
+        _out[0] = _out[1] = _out[2] = 0;
+        _resetHandshake();
+        _notify();
+    }
+
+    void schedulerEvent(u8 event, u64) override {
+        if (event < EVENT_ACK) _strobe(event - EVENT_STROBE, _strobeData[event - EVENT_STROBE]);
+        else acknowledge(event - EVENT_ACK);
+    }
+
+private:
+    enum Event : u8 { EVENT_STROBE = 0, EVENT_ACK = 2 };
+
+    // Mode 0, all ports are inputs
+    static const u8 CONTROL_RESET = 0x9B;
+
+    class Port : public BusDeviceReadable, public BusDeviceWritable {
+    public:
+        Port(Ppi8255 &ppi, u8 index) : _ppi(ppi), _index(index) {}
+
+        u8 busPortRead() override { return _ppi._read(_index); }
+        void busPortWrite(u8 data) override { _ppi._write(_index, data); }
+
+    private:
+        Ppi8255 &_ppi;
+        u8 _index;
+    };
+
+    Cpu &_cpu;
+    Scheduler &_scheduler;
+    Port _ports[4];
+
+    PpiListener *_listener = nullptr;
+    int _rst[2] = {-1, -1};
+    u32 _autoAck[2] = {0, 0};
+
+    u8 _control = CONTROL_RESET;
+    u8 _out[3] = {0, 0, 0};
+    u8 _ext[3] = {0xFF, 0xFF, 0xFF};
+
+    // Handshake state of ports A and B
+    u8   _inLatch[2] = {0, 0};
+    u8   _strobeData[2] = {0, 0};
+    bool _ibf[2] = {false, false};
+    bool _obf[2] = {false, false};
+    bool _intr[2] = {false, false};
+    u8   _inte = 0;                 // INTE flip-flops, at their PC bit positions
+
+    u8 _reported[3] = {0, 0, 0};
+
+    u8 _modeA() const { return (_control & 0x40) ? 2 : (_control >> 5) & 0x03; }
+    u8 _modeB() const { return (_control >> 2) & 0x01; }
+
+    bool _isOutput(u8 port) const {
+        if (port == PPI_PORT_A) return _modeA() == 2 || !(_control & 0x10);
+        return !(_control & 0x02);
+    }
+
+    // Port C bits taken by the handshakes
+    u8 _handshakeMask() const {
+        u8 mask = 0;
+
+        switch (_modeA()) {
+        case 1:  mask |= (_control & 0x10) ? 0x38 : 0xC8; break;
+        case 2:  mask |= 0xF8;                            break;
+        }
+
+        if (_modeB() == 1) mask |= 0x07;
+
+        return mask;
+    }
+
+    // PC bit of the INTE flip-flop for the input or output side of a port
+    u8 _inteBit(u8 port, bool output) const {
+        if (port == PPI_PORT_B) return 0x04;
+
+        return output ? 0x40 : 0x10;
+    }
+
+    bool _hasInput(u8 port) const {
+        if (port == PPI_PORT_A) return _modeA() == 2 || (_modeA() == 1 && (_control & 0x10));
+        return _modeB() == 1 && (_control & 0x02);
+    }
+
+    bool _hasOutput(u8 port) const {
+        if (port == PPI_PORT_A) return _modeA() == 2 || (_modeA() == 1 && !(_control & 0x10));
+        return _modeB() == 1 && !(_control & 0x02);
+    }
+
+    // Handshake lines as read by the CPU: INTR, IBF, OBF# and the INTE
+    // flip-flops in place of the STB#/ACK# inputs
+    u8 _statusC() const {
+        u8 status = _inte;
+
+        if (_modeA() != 0) {
+            if (_intr[0]) status |= 0x08;
+            if (_hasInput(PPI_PORT_A) && _ibf[0]) status |= 0x20;
+            if (_hasOutput(PPI_PORT_A) && !_obf[0]) status |= 0x80;
+        }
+
+        if (_modeB() == 1) {
+            if (_intr[1]) status |= 0x01;
+            if (_hasInput(PPI_PORT_B) ? _ibf[1] : !_obf[1]) status |= 0x02;
+        }
+
+        return status & _handshakeMask();
+    }
+
+    u8 _ioMaskC() const {
+        u8 outputs = 0;
+
+        if (!(_control & 0x08)) outputs |= 0xF0;
+        if (!(_control & 0x01)) outputs |= 0x0F;
+
+        return outputs;
+    }
+
+    u8 _pinsC() const {
+        u8 handshake = _handshakeMask();
+        u8 outputs = _ioMaskC() & ~handshake;
+
+        // STB#/ACK# are inputs, show their external level instead of INTE
+        u8 strobeLines = 0;
+        if (_modeA() != 0) strobeLines |= 0x50;
+        if (_modeB() == 1) strobeLines |= 0x04;
+        strobeLines &= handshake;
+
+        u8 status = _statusC() & ~strobeLines;
+
+        return (_out[2] & outputs) | (_ext[2] & ~outputs & ~handshake) |
+               status | (_ext[2] & strobeLines);
+    }
+
+    u8 _read(u8 index) {
+        switch (index) {
+        case PPI_PORT_A:
+        case PPI_PORT_B: {
+            u8 port = index;
+
+            if (_hasInput(port)) {
+                _ibf[port] = false;
+                _setIntr(port, false);
+                _notify();
+                return _inLatch[port];
+            }
+
+            return _isOutput(port) ? _out[port] : _ext[port];
+        }
+
+        case PPI_PORT_C: {
+            u8 handshake = _handshakeMask();
+            u8 outputs = _ioMaskC() & ~handshake;
+
+            return (_out[2] & outputs) | (_ext[2] & ~outputs & ~handshake) | _statusC();
+        }
+
+        default:
+            return 0xFF;
+        }
+    }
+
+    void _write(u8 index, u8 data) {
+        switch (index) {
+        case PPI_PORT_A:
+        case PPI_PORT_B: {
+            u8 port = index;
+
+            _out[port] = data;
+
+            if (_hasOutput(port)) {
+                _obf[port] = true;
+                _setIntr(port, false);
+
+                if (_autoAck[port]) {
+                    _scheduler.post(_cpu.getCycles() + _autoAck[port], *this, EVENT_ACK + port);
+                }
+            }
+            break;
+        }
+
+        case PPI_PORT_C:
+            // Handshake bits can't be written directly
+            _out[2] = (_out[2] & _handshakeMask()) | (data & ~_handshakeMask());
+            break;
+
+        default:
+            if (data & 0x80) _setMode(data);
+            else _bitSetReset(data);
+            break;
+        }
+
+        _notify();
+    }
+
+    void _setMode(u8 data) {
+        for (int i = 0; i < 4; i++) _scheduler.cancel(*this, i);
+
+        _control = data;
+        _out[0] = _out[1] = _out[2] = 0;
+        _resetHandshake();
+    }
+
+    void _bitSetReset(u8 data) {
+        u8 bit = 1 << ((data >> 1) & 0x07);
+        bool set = (data & 0x01) != 0;
+
+        // On the STB#/ACK# positions the command controls INTE
+        u8 inteBits = 0;
+        if (_modeA() != 0) inteBits |= _handshakeMask() & 0x50;
+        if (_modeB() == 1) inteBits |= 0x04;
+
+        if (bit & inteBits) {
+            _inte = set ? (_inte | bit) : (_inte & ~bit);
+            _updateIntr();
+            return;
+        }
+
+        if (bit & _handshakeMask()) return;
+
+        _out[2] = set ? (_out[2] | bit) : (_out[2] & ~bit);
+    }
+
+    void _resetHandshake() {
+        _ibf[0] = _ibf[1] = false;
+        _obf[0] = _obf[1] = false;
+        _intr[0] = _intr[1] = false;
+        _inte = 0;
+    }
+
+    void _strobe(u8 port, u8 data) {
+        if (!_hasInput(port)) return;
+
+        _inLatch[port] = data;
+        _ibf[port] = true;
+        _requestIntr(port, _inteBit(port, false));
+        _notify();
+    }
+
+    // INTR follows its condition when INTE changes
+    void _updateIntr() {
+        for (u8 port = 0; port < 2; port++) {
+            bool in  = _hasInput(port) && _ibf[port] && (_inte & _inteBit(port, false));
+            bool out = _hasOutput(port) && !_obf[port] && (_inte & _inteBit(port, true));
+
+            _setIntr(port, in || out);
+        }
+    }
+
+    // `inte` is the INTE bit that has to be set for the request to pass
+    void _requestIntr(u8 port, u8 inte) { _setIntr(port, (_inte & inte) != 0); }
+
+    void _setIntr(u8 port, bool level) {
+        if (level && !_intr[port] && _rst[port] >= 0) _cpu.requestInterrupt(_rst[port]);
+
+        _intr[port] = level;
+    }
+
+    void _notify() {
+        if (_listener == nullptr) return;
+
+        for (u8 port = 0; port < 3; port++) {
+            u8 pins = getPins(port);
+
+            if (pins == _reported[port]) continue;
+
+            _reported[port] = pins;
+            _listener->ppiPortChanged(port, _cpu.getCycles(), pins);
+        }
+    }
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+
+#include "bus.hpp"
+#include "ring.hpp"
+
+#define PRINTER_BUFFER_SIZE 0x10000
+
+// Centronics-style printer, data at base and status at base+1.
+// Writing the data port prints the byte: it goes into a lock-free ring
+// that the host drains on its own thread, so the emulation never waits
+// on file I/O. BUSY is raised while the ring is full; a program that
+// ignores it loses the bytes, and they are counted as dropped.
+class Printer {
+public:
+    Printer() : _data(*this, false), _status(*this, true) {}
+
+    void bind(Bus &bus, u8 basePort) {
+        bus.portBindIn(basePort, _data);
+        bus.portBindOut(basePort, _data);
+        bus.portBindIn(basePort + 1, _status);
+        bus.portBindOut(basePort + 1, _status);
+    }
+
+    void unbind(Bus &bus, u8 basePort) {
+        bus.portUnbindIn(basePort, _data);
+        bus.portUnbindOut(basePort, _data);
+        bus.portUnbindIn(basePort + 1, _status);
+        bus.portUnbindOut(basePort + 1, _status);
+    }
+
+    // Consumer side, false when nothing is waiting to be printed
+    bool take(u8 &data) { return _paper.pop(data); }
+
+    u32 pending() const { return _paper.size(); }
+
+    // Bytes the CPU wrote to the data port, emulation thread only
+    u64 printed() const { return _printed; }
+
+    u64 dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+    // Status register bits, the rest read as zero
+    static const u8 STATUS_ERROR  = 0x08;   // ERROR#, high - no error
+    static const u8 STATUS_SELECT = 0x10;   // Printer is online
+    static const u8 STATUS_BUSY   = 0x80;
+
+    class Port : public BusDeviceReadable, public BusDeviceWritable {
+    public:
+        Port(Printer &printer, bool status) : _printer(printer), _isStatus(status) {}
+
+        u8 busPortRead() override {
+            return _isStatus ? _printer._readStatus() : _printer._last;
+        }
+
+        void busPortWrite(u8 data) override {
+            if (!_isStatus) _printer._print(data);
+        }
+
+    private:
+        Printer &_printer;
+        bool _isStatus;
+    };
+
+    Port _data;
+    Port _status;
+
+    SpscRing<u8, PRINTER_BUFFER_SIZE> _paper;
+    std::atomic<u64> _dropped{0};
+    u64 _printed = 0;
+    u8 _last = 0;
+
+    u8 _readStatus() const {
+        u8 status = STATUS_ERROR | STATUS_SELECT;
+
+        if (_paper.size() == _paper.capacity()) status |= STATUS_BUSY;
+
+        return status;
+    }
+
+    void _print(u8 data) {
+        _last = data;
+        _printed++;
+
+        if (!_paper.push(data)) _dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+};
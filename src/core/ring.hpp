@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+#include "inttypes.hpp"
+
+// Lock-free single producer / single consumer queue,
+// SIZE must be a power of two
+template <typename T, u32 SIZE>
+class SpscRing {
+public:
+    // Producer side, false if the ring is full
+    bool push(const T& item) {
+        u32 head = _head.load(std::memory_order_relaxed);
+
+        if (head - _tail.load(std::memory_order_acquire) == SIZE) return false;
+
+        _items[head & (SIZE - 1)] = item;
+        _head.store(head + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // Consumer side, false if the ring is empty. The item is moved out,
+    // so the slot keeps no resources of its own.
+    bool pop(T& item) {
+        u32 tail = _tail.load(std::memory_order_relaxed);
+
+        if (_head.load(std::memory_order_acquire) == tail) return false;
+
+        item = std::move(_items[tail & (SIZE - 1)]);
+        _tail.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    bool peek(T& item) const {
+        u32 tail = _tail.load(std::memory_order_relaxed);
+
+        if (_head.load(std::memory_order_acquire) == tail) return false;
+
+        item = _items[tail & (SIZE - 1)];
+
+        return true;
+    }
+
+    u32 size() const {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+
+    static u32 capacity() { return SIZE; }
+
+private:
+    T _items[SIZE];
+
+    // Producer and consumer indices live on separate cache lines.
+    // Padding instead of alignas, so rings can be heap allocated in C++11
+    char _padItems[64];
+    std::atomic<u32> _head{0};
+    char _padHead[64 - sizeof(std::atomic<u32>)];
+    std::atomic<u32> _tail{0};
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "inttypes.hpp"
+
+#define SCHEDULER_CAPACITY  32
+#define SCHEDULER_NEVER     0xFFFFFFFFFFFFFFFFULL
+
+class SchedulerClient {
+public:
+    virtual void schedulerEvent(u8 event, u64 cycle) = 0;
+};
+
+// Min-heap of device events keyed on the CPU cycle counter.
+// The run loop only has to compare the cycle counter against
+// nextDeadline() and call dispatch() once it is reached.
+class Scheduler {
+public:
+    u64 nextDeadline() const { return _count ? _heap[0].cycle : SCHEDULER_NEVER; }
+
+    // Posts (or moves, if already pending) the event of the client
+    bool post(u64 cycle, SchedulerClient& client, u8 event = 0) {
+        int i = _find(client, event);
+
+        if (i < 0) {
+            if (_count == SCHEDULER_CAPACITY) return false;
+            i = _count++;
+        }
+
+        _heap[i] = { cycle, _sequence++, &client, event };
+        _siftUp(i);
+        _siftDown(i);
+
+        return true;
+    }
+
+    void cancel(SchedulerClient& client, u8 event = 0) {
+        int i = _find(client, event);
+
+        if (i >= 0) _remove(i);
+    }
+
+    bool isPending(SchedulerClient& client, u8 event = 0) const {
+        return _find(client, event) >= 0;
+    }
+
+    // Fires every event due at `now`, in deadline order
+    void dispatch(u64 now) {
+        while (_count && _heap[0].cycle <= now) {
+            Event e = _heap[0];
+            _remove(0);
+
+            e.client->schedulerEvent(e.event, e.cycle);
+        }
+    }
+
+    void clear() { _count = 0; }
+
+private:
+    struct Event {
+        u64 cycle;
+        u64 sequence;
+        SchedulerClient* client;
+        u8 event;
+    };
+
+    Event _heap[SCHEDULER_CAPACITY];
+    int   _count    = 0;
+    u64   _sequence = 0;
+
+    // Same deadline fires in posting order
+    static bool _before(const Event& a, const Event& b) {
+        return (a.cycle != b.cycle) ? a.cycle < b.cycle : a.sequence < b.sequence;
+    }
+
+    int _find(const SchedulerClient& client, u8 event) const {
+        for (int i = 0; i < _count; i++) {
+            if (_heap[i].client == &client && _heap[i].event == event) return i;
+        }
+
+        return -1;
+    }
+
+    void _remove(int i) {
+        _heap[i] = _heap[--_count];
+
+        if (i < _count) {
+            _siftUp(i);
+            _siftDown(i);
+        }
+    }
+
+    void _siftUp(int i) {
+        while (i > 0) {
+            int parent = (i - 1) / 2;
+
+            if (!_before(_heap[i], _heap[parent])) break;
+
+            _swap(i, parent);
+            i = parent;
+        }
+    }
+
+    void _siftDown(int i) {
+        for (;;) {
+            int smallest = i;
+            int left  = i * 2 + 1;
+            int right = i * 2 + 2;
+
+            if (left < _count && _before(_heap[left], _heap[smallest]))   smallest = left;
+            if (right < _count && _before(_heap[right], _heap[smallest])) smallest = right;
+
+            if (smallest == i) break;
+
+            _swap(i, smallest);
+            i = smallest;
+        }
+    }
+
+    void _swap(int a, int b) {
+        Event t = _heap[a];
+        _heap[a] = _heap[b];
+        _heap[b] = t;
+    }
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "bus.hpp"
+#include "cpu.hpp"
+
+class SpeakerListener {
+public:
+    virtual void speakerLevel(u64 cycle, bool level) = 0;
+};
+
+// Dynamic speaker on the speaker port, driven by bit 0.
+// Every level change is reported with the cycle it happened at.
+class Speaker : public BusDeviceWritable {
+public:
+    Speaker(const Cpu& cpu) : _cpu(cpu) {}
+
+    void busPortWrite(u8 data) {
+        bool level = (data & 0x01) != 0;
+
+        if (level == _level) return;
+
+        _level = level;
+
+        if (_listener != nullptr) _listener->speakerLevel(_cpu.getCycles(), level);
+    }
+
+    bool getLevel() const { return _level; }
+
+    void setListener(SpeakerListener* listener) { _listener = listener; }
+
+private:
+    const Cpu& _cpu;
+
+    bool _level = false;
+    SpeakerListener* _listener = nullptr;
+};
@@ -0,0 +1,416 @@
+#pragma once
+
+#include "bus.hpp"
+#include "cpu.hpp"
+#include "scheduler.hpp"
+
+#define TIMER_COUNTERS 3
+
+class TimerListener {
+public:
+    virtual void timerOutput(u8 counter, u64 cycle, bool level) = 0;
+};
+
+// KR580VI53 (Intel 8253) programmable interval timer.
+// Counts are derived from the CPU cycle counter when read, and OUT edges
+// are posted to the scheduler, so nothing runs per instruction.
+// A rising OUT edge can request an RST interrupt on the CPU's INTR line.
+class Timer8253 : public SchedulerClient {
+public:
+    Timer8253(Cpu &cpu, Scheduler &scheduler)
+        : _cpu(cpu), _scheduler(scheduler),
+          _ports{{*this, 0}, {*this, 1}, {*this, 2}, {*this, 3}} {}
+
+    // Counters at base..base+2, control word at base+3
+    void bind(Bus &bus, u8 basePort) {
+        for (int i = 0; i < 4; i++) {
+            bus.portBindIn(basePort + i, _ports[i]);
+            bus.portBindOut(basePort + i, _ports[i]);
+        }
+    }
+
+    void unbind(Bus &bus, u8 basePort) {
+        for (int i = 0; i < 4; i++) {
+            bus.portUnbindIn(basePort + i, _ports[i]);
+            bus.portUnbindOut(basePort + i, _ports[i]);
+        }
+    }
+
+    // CPU cycles per CLK period of the counters
+    void setClockDivider(u32 cycles) { _cyclesPerClock = cycles ? cycles : 1; }
+    u32 getClockDivider() const { return _cyclesPerClock; }
+
+    // Rising OUT edges of `counter` raise RST `rstNum`, -1 disconnects
+    void setInterrupt(u8 counter, int rstNum) { _rst[counter] = rstNum; }
+
+    void setListener(TimerListener *listener) { _listener = listener; }
+
+    bool getOutput(u8 counter) const { return _counters[counter].out; }
+
+    void setGate(u8 counter, bool level) {
+        Counter &c = _counters[counter];
+
+        if (level == c.gate) return;
+
+        c.gate = level;
+
+        u64 now = _cpu.getCycles();
+
+        switch (c.mode) {
+        case 0:
+        case 4:
+            // Gate low suspends counting
+            if (!c.armed || c.done) break;
+
+            if (!level) {
+                c.load = _read(c);
+                c.paused = true;
+                _scheduler.cancel(*this, counter);
+            } else {
+                c.paused = false;
+                c.start = now;
+                _scheduleTerminal(counter);
+            }
+            break;
+
+        case 1:
+        case 5:
+            if (level && c.written != NULL_COUNT) _trigger(counter, now);
+            break;
+
+        case 2:
+        case 3:
+            if (!level) {
+                c.paused = true;
+                _scheduler.cancel(*this, counter);
+                _setOutput(counter, now, true);
+            } else if (c.written != NULL_COUNT) {
+                c.paused = false;
+                _trigger(counter, now);
+            }
+            break;
+        }
+    }
+
+    void reset() {
+        for (u8 i = 0; i < TIMER_COUNTERS; i++) {
+            _scheduler.cancel(*this, i);
+            _counters[i] = Counter();
+        }
+    }
+
+    void schedulerEvent(u8 event, u64 cycle) override {
+        Counter &c = _counters[event];
+        u64 clock = _cyclesPerClock;
+        u32 n = _modulus(c, c.load);
+
+        _setOutput(event, cycle, c.edge);
+
+        switch (c.mode) {
+        case 0:
+            c.done = true;
+            break;
+
+        case 1:
+            if (!c.edge) _post(event, c.start + n * clock, true);
+            else c.done = true;
+            break;
+
+        case 4:
+        case 5:
+            if (!c.edge) _post(event, cycle + clock, true);
+            else c.done = true;
+            break;
+
+        case 2:
+            if (!c.edge) {
+                _post(event, cycle + clock, true);
+            } else {
+                _nextPeriod(c, cycle);
+                _post(event, c.start + (_modulus(c, c.load) - 1) * clock, false);
+            }
+            break;
+
+        case 3:
+            if (!c.edge) {
+                _post(event, c.start + n * clock, true);
+            } else {
+                _nextPeriod(c, cycle);
+                _post(event, c.start + (_modulus(c, c.load) + 1) / 2 * clock, false);
+            }
+            break;
+        }
+    }
+
+private:
+    static const u32 NULL_COUNT = 0xFFFFFFFF;
+
+    class Port : public BusDeviceReadable, public BusDeviceWritable {
+    public:
+        Port(Timer8253 &timer, u8 index) : _timer(timer), _index(index) {}
+
+        u8 busPortRead() override { return _timer._portRead(_index); }
+        void busPortWrite(u8 data) override { _timer._portWrite(_index, data); }
+
+    private:
+        Timer8253 &_timer;
+        u8 _index;
+    };
+
+    struct Counter {
+        u8   mode = 0;
+        u8   access = 3;           // 1 - LSB, 2 - MSB, 3 - LSB then MSB
+        bool bcd = false;
+
+        u32  written = NULL_COUNT; // Last complete count written
+        u32  load = 0;             // Count at `start`
+        u64  start = 0;            // Cycle counting (re)started at
+
+        bool armed = false;
+        bool paused = false;
+        bool done = false;         // One-shot finished
+        bool gate = true;
+        bool out = true;
+        bool edge = false;         // Level of the pending OUT edge
+
+        u8   lsb = 0;
+        bool msbNext = false;      // Next written byte is the MSB
+        bool readMsb = false;      // Next read byte is the MSB
+        bool latched = false;
+        u16  latch = 0;
+    };
+
+    Cpu &_cpu;
+    Scheduler &_scheduler;
+    Port _ports[4];
+
+    Counter _counters[TIMER_COUNTERS];
+    int _rst[TIMER_COUNTERS] = {-1, -1, -1};
+
+    u32 _cyclesPerClock = 1;
+    TimerListener *_listener = nullptr;
+
+    u8 _portRead(u8 index) {
+        if (index >= TIMER_COUNTERS) return 0xFF;
+
+        Counter &c = _counters[index];
+        u16 value = c.latched ? c.latch : _encode(c, _read(c));
+        u8 data;
+
+        switch (c.access) {
+        case 1:  data = value & 0xFF;        c.latched = false; break;
+        case 2:  data = (value >> 8) & 0xFF; c.latched = false; break;
+        default:
+            data = c.readMsb ? (value >> 8) & 0xFF : value & 0xFF;
+            if (c.readMsb) c.latched = false;
+            c.readMsb = !c.readMsb;
+            break;
+        }
+
+        return data;
+    }
+
+    void _portWrite(u8 index, u8 data) {
+        if (index == 3) {
+            _control(data);
+            return;
+        }
+
+        Counter &c = _counters[index];
+        u16 value;
+
+        switch (c.access) {
+        case 1: value = data;      break;
+        case 2: value = data << 8; break;
+        default:
+            if (!c.msbNext) {
+                c.lsb = data;
+                c.msbNext = true;
+                return;
+            }
+            c.msbNext = false;
+            value = (data << 8) | c.lsb;
+            break;
+        }
+
+        _loadCount(index, _decode(c, value));
+    }
+
+    void _control(u8 data) {
+        u8 index  = (data >> 6) & 0x03;
+        u8 access = (data >> 4) & 0x03;
+
+        // 8253 has no read-back command
+        if (index == 3) return;
+
+        Counter &c = _counters[index];
+
+        if (access == 0) {
+            // Counter latch command
+            if (!c.latched) {
+                c.latch = _encode(c, _read(c));
+                c.latched = true;
+                c.readMsb = false;
+            }
+            return;
+        }
+
+        _scheduler.cancel(*this, index);
+
+        bool gate = c.gate;
+        bool out  = c.out;
+        c = Counter();
+
+        c.gate   = gate;
+        c.out    = out;
+        c.access = access;
+        c.mode   = (data >> 1) & 0x07;
+        c.bcd    = (data & 0x01) != 0;
+
+        // Modes 6 and 7 are aliases of 2 and 3
+        if (c.mode > 5) c.mode -= 4;
+
+        _setOutput(index, _cpu.getCycles(), c.mode != 0);
+    }
+
+    void _loadCount(u8 index, u32 count) {
+        Counter &c = _counters[index];
+        u64 now = _cpu.getCycles();
+
+        bool running = c.armed && (c.mode == 2 || c.mode == 3);
+
+        c.written = count;
+
+        switch (c.mode) {
+        case 0:
+        case 4:
+            // Counting starts on the clock after the write
+            _setOutput(index, now, c.mode != 0);
+            c.load   = count;
+            c.start  = now + _cyclesPerClock;
+            c.armed  = true;
+            c.done   = false;
+            c.paused = !c.gate;
+
+            if (c.paused) c.start = now;
+            else _scheduleTerminal(index);
+            break;
+
+        case 2:
+        case 3:
+            // A running generator picks the new count up at the end
+            // of the current period
+            if (!running && c.gate) _trigger(index, now);
+            break;
+
+        default:
+            // Modes 1 and 5 wait for a gate trigger
+            break;
+        }
+    }
+
+    void _trigger(u8 index, u64 now) {
+        Counter &c = _counters[index];
+        u64 clock = _cyclesPerClock;
+
+        c.load  = c.written;
+        c.start = now + clock;
+        c.armed = true;
+        c.done  = false;
+
+        u32 n = _modulus(c, c.load);
+
+        switch (c.mode) {
+        case 1: _post(index, c.start, false);                        break;
+        case 5: _post(index, c.start + n * clock, false);            break;
+        case 2: _post(index, c.start + (n - 1) * clock, false);      break;
+        case 3: _post(index, c.start + (n + 1) / 2 * clock, false);  break;
+        }
+    }
+
+    // Terminal count of modes 0 and 4 from the current `load`
+    void _scheduleTerminal(u8 index) {
+        Counter &c = _counters[index];
+        u64 at = c.start + (u64)_modulus(c, c.load) * _cyclesPerClock;
+
+        _post(index, at, c.mode == 0);
+    }
+
+    void _nextPeriod(Counter &c, u64 cycle) {
+        c.start = cycle;
+        c.load  = c.written;
+    }
+
+    void _post(u8 index, u64 cycle, bool level) {
+        _counters[index].edge = level;
+        _scheduler.post(cycle, *this, index);
+    }
+
+    void _setOutput(u8 index, u64 cycle, bool level) {
+        Counter &c = _counters[index];
+
+        if (c.out == level) return;
+
+        c.out = level;
+
+        if (_listener != nullptr) _listener->timerOutput(index, cycle, level);
+
+        if (level && _rst[index] >= 0) _cpu.requestInterrupt(_rst[index]);
+    }
+
+    // Current count as the counter element holds it
+    u32 _read(const Counter &c) const {
+        if (!c.armed) return (c.written == NULL_COUNT) ? 0 : c.written;
+        if (c.paused) return c.load;
+
+        u64 now = _cpu.getCycles();
+        u32 n = _modulus(c, c.load);
+
+        if (now < c.start) return c.load;
+
+        u64 clocks = (now - c.start) / _cyclesPerClock;
+
+        switch (c.mode) {
+        case 2:
+            return n - (u32)(clocks % n);
+
+        case 3: {
+            // Counts down by two through each half of the period
+            u32 pos  = (u32)(clocks % n);
+            u32 high = (n + 1) / 2;
+            u32 half = (pos < high) ? pos : pos - high;
+
+            return (n - 2 * half) & ~1u;
+        }
+
+        default: {
+            u32 modulus = c.bcd ? 10000 : 0x10000;
+            return (u32)((n + modulus - clocks % modulus) % modulus);
+        }
+        }
+    }
+
+    // 0 stands for the maximum count, mode 2 and 3 need at least 2
+    static u32 _modulus(const Counter &c, u32 count) {
+        if (count == 0) count = c.bcd ? 10000 : 0x10000;
+        if (count < 2 && (c.mode == 2 || c.mode == 3)) count = 2;
+
+        return count;
+    }
+
+    static u32 _decode(const Counter &c, u16 value) {
+        if (!c.bcd) return value;
+
+        return ((value >> 12) & 0xF) * 1000 + ((value >> 8) & 0xF) * 100 +
+               ((value >> 4) & 0xF) * 10 + (value & 0xF);
+    }
+
+    static u16 _encode(const Counter &c, u32 value) {
+        if (!c.bcd) return (u16)value;
+
+        value %= 10000;
+
+        return (u16)(((value / 1000) << 12) | (((value / 100) % 10) << 8) |
+                     (((value / 10) % 10) << 4) | (value % 10));
+    }
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+
+#include "inttypes.hpp"
+
+// Hands the latest version of a value from one producer thread to one
+// consumer thread without locks. The producer fills its back slot and
+// swaps it with the middle one, the consumer swaps the middle slot for
+// its front one when a newer version is there. Neither side ever waits,
+// a slow consumer only skips versions.
+template <typename T>
+class TripleBuffer {
+public:
+    // Producer side, the slot keeps an older version, fill it whole
+    T& back() { return _slots[_back]; }
+
+    void publish() {
+        _back = _middle.exchange(_back | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // Consumer side, false if nothing was published since the last call
+    bool acquire() {
+        if (!(_middle.load(std::memory_order_relaxed) & FRESH)) return false;
+
+        _front = _middle.exchange(_front, std::memory_order_acq_rel) & INDEX;
+
+        return true;
+    }
+
+    const T& front() const { return _slots[_front]; }
+
+private:
+    static const u8 INDEX = 0x03;
+    static const u8 FRESH = 0x04;
+
+    T _slots[3];
+
+    u8 _back = 0;
+    u8 _front = 1;
+    std::atomic<u8> _middle{2};
+};
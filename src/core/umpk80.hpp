@@ -1,32 +1,81 @@
 #pragma once
 
+#include <atomic>
+
+#include "addressmarks.hpp"
+#include "analog.hpp"
+#include "breakpoints.hpp"
 #include "bus.hpp"
 #include "cpu.hpp"
 #include "display.hpp"
+#include "hle.hpp"
 #include "keyboard.hpp"
+#include "ppi8255.hpp"
+#include "printer.hpp"
 #include "register.hpp"
+#include "ring.hpp"
+#include "scheduler.hpp"
+#include "speaker.hpp"
+#include "timer8253.hpp"
+#include "usart8251.hpp"
 
 #define UMPK80_OS_SIZE 0x800
-
-class RegisterControlStep : public BusDeviceWritable {
+#define UMPK80_CLOCK_HZ 2000000
+#define UMPK80_KEY_QUEUE_SIZE 256
+#define UMPK80_INTERRUPT_QUEUE_SIZE 256
+
+// Writing to the step register makes the hardware raise RST 1 right after
+// the next user instruction. The monitor writes it at 0BD5h and then runs
+// NOP (0BD7h) and JMP USER (0BD8h), so the trap is armed to fire on the
+// first instruction boundary past the start of the user instruction.
+class RegisterControlStep : public BusDeviceWritable, public SchedulerClient {
 public:
-    void busPortWrite(u8 data) { turnOnStepExec(); }
+    RegisterControlStep(Cpu &cpu, Scheduler &scheduler)
+        : _cpu(cpu), _scheduler(scheduler) {}
 
-    bool isStepExec() { return _isStepExec; }
+    void busPortWrite(u8) override {
+        _scheduler.post(_cpu.getCycles() + STEP_TRAP_DELAY, *this);
+    }
 
-    void turnOnStepExec() { _isStepExec = true; }
-    void turnOffStepExec() { _isStepExec = false; }
+    void schedulerEvent(u8, u64) override { _cpu.interruptRst(1); }
 
 private:
-    bool _isStepExec = false;
+    // NOP + JMP + first state of the user instruction
+    static const u8 STEP_TRAP_DELAY = 4 + 10 + 1;
+
+    Cpu &_cpu;
+    Scheduler &_scheduler;
 };
 
-class Umpk80 {
+class Umpk80 : private SchedulerClient {
 private:
     const u16 SAVPC = 0x0BDC;
+
+    // Monitor's one-time display scan: multiplexes the seven-segment
+    // codes from 0BFAh-0BFFh onto ports 06h/07h with a 1 ms delay per digit
+    const u16 MONITOR_DISPLAY_BUFFER      = 0x0BFA;
+    const u32 MONITOR_DISPLAY_SCAN_CYCLES = 10718;
+    // Return address of its CALL of the 1 ms delay and the flags the
+    // delay pushes, those of XRA A
+    const u16 MONITOR_SCAN_DELAY_RETURN   = 0x01DC;
+    const u8  MONITOR_SCAN_DELAY_FLAGS    = 0x46;
+
+    // Message decoding: codes from 0BF0h-0BF5h are looked up in the
+    // segment table, a nonzero 0BF6h lights the first digit's dot
+    const u16 MONITOR_MESSAGE             = 0x0BF0;
+    const u16 MONITOR_SEGMENT_TABLE       = 0x0218;
+    // Its CALL of the display scan
+    const u16 MONITOR_DECODE_SCAN_CALL    = 0x0214;
 public:
     Umpk80()
-        : _intel8080(_bus), _keyboard(_registerScan), _registerScan(_display) {
+        : _intel8080(_bus), _keyboard(_registerScan), _display(_intel8080),
+          _registerScan(_display), _speaker(_intel8080),
+          _registerStepExec(_intel8080, _scheduler),
+          _timer(_intel8080, _scheduler),
+          _usart(_intel8080, _scheduler, UMPK80_CLOCK_HZ),
+          _ppi(_intel8080, _scheduler),
+          _dac(_intel8080), _adc(_intel8080),
+          _breakpoints(_marks, _intel8080, _bus) {
         _bindDevices();
     }
 
@@ -54,19 +103,65 @@ public:
 
     u8 port5OutGet() { return _register5Out.busPortRead(); }
 
+    // Executes one instruction
     void tick() {
-        if (!_registerStepExec.isStepExec()) {
-            _intel8080.tick();
-        } else {
-            _intel8080.tick(); // 0bd7 NOP
-            _intel8080.tick(); // 0bd8 JMP USER
-            _intel8080.tick(); // USER INST
-            _intel8080.interruptRst(1);
-
-            _registerStepExec.turnOffStepExec();
+        _applyQueuedEvents();
+        _step();
+
+        if (_intel8080.getCycles() >= _scheduler.nextDeadline())
+            _scheduler.dispatch(_intel8080.getCycles());
+    }
+
+    // Executes one instruction. Unlike tick() events queued from other
+    // threads wait for the next applyQueuedEvents(), timed ones that
+    // are already armed still come at their cycle.
+    // True when an HLE handler ran in place of a routine and returned
+    // from it, popping the frame without a RET opcode
+    bool step() {
+        bool returned = _step();
+
+        if (_intel8080.getCycles() >= _scheduler.nextDeadline())
+            _scheduler.dispatch(_intel8080.getCycles());
+
+        return returned;
+    }
+
+    // Applies the key and interrupt events queued from other threads
+    // that are due, for hosts driving the machine with step()
+    void applyQueuedEvents() { _applyQueuedEvents(); }
+
+    // Executes instructions for at least `cycles` states,
+    // device events are only looked at when their deadline is reached.
+    // True when a breakpoint stopped it early, before the instruction
+    // at the breakpoint.
+    bool run(u64 cycles) {
+        u64 target = _intel8080.getCycles() + cycles;
+        bool stopped = false;
+
+        while (!stopped && _intel8080.getCycles() < target) {
+            _applyQueuedEvents();
+
+            // Port writes may post an earlier deadline, so it is re-read
+            // after every instruction. Events queued from other threads
+            // end the slice too, so they are seen on the next boundary.
+            while (!stopped && _intel8080.getCycles() < target &&
+                   _intel8080.getCycles() < _scheduler.nextDeadline() &&
+                   !_eventsQueued.load(std::memory_order_relaxed)) {
+                _step();
+
+                u16 pc = _intel8080.getProgramCounter();
+                stopped = _marks.test(pc) && _breakpoints.check(pc);
+            }
+
+            if (_intel8080.getCycles() >= _scheduler.nextDeadline())
+                _scheduler.dispatch(_intel8080.getCycles());
         }
+
+        return stopped;
     }
 
+    u64 getCycles() const { return _intel8080.getCycles(); }
+
     void stop() { _intel8080.interruptRst(1); }
     void restart() { _intel8080.interruptRst(0); }
 
@@ -97,7 +192,167 @@ public:
 
     bool getKeyState(KeyboardKey key) { return _keyboard.isKeyPressed(key); }
 
+    // Queues a key change to be applied once the emulation reaches `cycle`
+    // (0 means as soon as possible). Events are applied in queue order,
+    // so scripted input should be queued with non-decreasing cycles.
+    // Lock-free, safe to call from one thread other than the emulation one.
+    // Returns false if the queue is full.
+    bool queueKey(KeyboardKey key, bool pressed, u64 cycle = 0) {
+        if (!_keyEvents.push({cycle, key, pressed})) return false;
+
+        _eventsQueued.store(true, std::memory_order_release);
+        return true;
+    }
+
+    // Queues an RST `rstNum` request on INTR for when the emulation
+    // reaches `cycle` (0 or a past cycle - the next instruction boundary).
+    // The CPU takes it once interrupts are enabled, unlike stop() and
+    // restart() which force their RST. Requests are applied in queue
+    // order, so they should be queued with non-decreasing cycles; every
+    // one is delivered, a repeated RST waits until the last is taken.
+    // Safe to call from any thread without the emulation being stopped.
+    // Returns false if the queue is full.
+    bool queueInterrupt(int rstNum, u64 cycle = 0) {
+        if (rstNum < 0 || rstNum > 7) return false;
+
+        // Producers take turns, the emulation thread never waits here
+        while (_interruptQueueLock.test_and_set(std::memory_order_acquire)) {}
+        bool queued = _interruptEvents.push({cycle, (u8)rstNum});
+        _interruptQueueLock.clear(std::memory_order_release);
+
+        if (queued) _eventsQueued.store(true, std::memory_order_release);
+
+        return queued;
+    }
+
     u8 getDisplayDigit(int digit) { return _display.get(digit); }
+    u8 getDisplayBrightness(int digit) { return _display.getBrightness(digit); }
+
+    // How long (in states) a digit stays lit after the last refresh
+    void setDisplayPersistence(u32 cycles) { _display.setPersistence(cycles); }
+
+    // Runs a monitor routine at a high level (see HleRoutine) or, when
+    // disabled, as the ROM code
+    void setHle(HleRoutine routine, bool enabled) {
+        u16 address = hleRoutineInfo(routine).address;
+
+        if (enabled == (_hleAt[address] != 0)) return;
+
+        _hleAt[address] = enabled ? (u8)routine + 1 : 0;
+
+        if (enabled) _marks.add(address);
+        else _marks.remove(address);
+    }
+
+    bool isHle(HleRoutine routine) const {
+        return _hleAt[hleRoutineInfo(routine).address] != 0;
+    }
+
+    // Addresses a host looks at before the instruction there runs (hooks,
+    // breakpoints), so its run loop only tests isAddressMarked(pc).
+    // Counted, every markAddress() needs its own unmarkAddress().
+    void markAddress(u16 adr) { _marks.add(adr); }
+    void unmarkAddress(u16 adr) { _marks.remove(adr); }
+    bool isAddressMarked(u16 adr) const { return _marks.test(adr); }
+
+    // Runs the monitor's display scan routine at a high level: the digits
+    // are lit straight from its segment buffer instead of emulating every
+    // OUT and delay loop. Programs that drive ports 06h/07h themselves
+    // still go through the regular port-level emulation.
+    void setDisplayFastPath(bool enabled) { setHle(HleRoutine::DisplayScan, enabled); }
+    bool isDisplayFastPath() const { return isHle(HleRoutine::DisplayScan); }
+
+    // Receives cycle-stamped level changes of the speaker port
+    void setSpeakerListener(SpeakerListener* listener) { _speaker.setListener(listener); }
+
+    // The set*Port() calls return false, keeping the old mapping, when a
+    // port is outside 00h-FFh or already taken by a built-in device or
+    // another module. Ports a module leaves become free again.
+
+    // Maps the 8253 timer module to basePort..basePort+3, -1 unmaps it
+    bool setTimerPort(int basePort) {
+        if (_timerPort >= 0) _timer.unbind(_bus, (u8)_timerPort);
+
+        bool mapped = basePort < 0 || _portsFree(basePort, 4, true, true);
+        if (mapped) _timerPort = basePort;
+
+        if (_timerPort >= 0) _timer.bind(_bus, (u8)_timerPort);
+        return mapped;
+    }
+
+    int getTimerPort() const { return _timerPort; }
+    Timer8253 &getTimer() { return _timer; }
+
+    // Maps the 8251 USART module to basePort (data) and basePort+1
+    // (control/status), -1 unmaps it
+    bool setUsartPort(int basePort) {
+        if (_usartPort >= 0) _usart.unbind(_bus, (u8)_usartPort);
+
+        bool mapped = basePort < 0 || _portsFree(basePort, 2, true, true);
+        if (mapped) _usartPort = basePort;
+
+        if (_usartPort >= 0) _usart.bind(_bus, (u8)_usartPort);
+        return mapped;
+    }
+
+    int getUsartPort() const { return _usartPort; }
+    Usart8251 &getUsart() { return _usart; }
+
+    // Maps the 8255 PPI module to basePort..basePort+3, -1 unmaps it
+    bool setPpiPort(int basePort) {
+        if (_ppiPort >= 0) _ppi.unbind(_bus, (u8)_ppiPort);
+
+        bool mapped = basePort < 0 || _portsFree(basePort, 4, true, true);
+        if (mapped) _ppiPort = basePort;
+
+        if (_ppiPort >= 0) _ppi.bind(_bus, (u8)_ppiPort);
+        return mapped;
+    }
+
+    int getPpiPort() const { return _ppiPort; }
+    Ppi8255 &getPpi() { return _ppi; }
+
+    // Maps the printer to basePort (data) and basePort+1 (status),
+    // -1 unmaps it
+    bool setPrinterPort(int basePort) {
+        if (_printerPort >= 0) _printer.unbind(_bus, (u8)_printerPort);
+
+        bool mapped = basePort < 0 || _portsFree(basePort, 2, true, true);
+        if (mapped) _printerPort = basePort;
+
+        if (_printerPort >= 0) _printer.bind(_bus, (u8)_printerPort);
+        return mapped;
+    }
+
+    int getPrinterPort() const { return _printerPort; }
+    Printer &getPrinter() { return _printer; }
+
+    // Maps the DAC to an output port and the ADC to an input port,
+    // they may share one. -1 unmaps.
+    bool setDacPort(int port) {
+        if (_dacPort >= 0) _bus.portUnbindOut((u8)_dacPort, _dac);
+
+        bool mapped = port < 0 || _portsFree(port, 1, false, true);
+        if (mapped) _dacPort = port;
+
+        if (_dacPort >= 0) _bus.portBindOut((u8)_dacPort, _dac);
+        return mapped;
+    }
+
+    bool setAdcPort(int port) {
+        if (_adcPort >= 0) _bus.portUnbindIn((u8)_adcPort, _adc);
+
+        bool mapped = port < 0 || _portsFree(port, 1, true, false);
+        if (mapped) _adcPort = port;
+
+        if (_adcPort >= 0) _bus.portBindIn((u8)_adcPort, _adc);
+        return mapped;
+    }
+
+    int getDacPort() const { return _dacPort; }
+    int getAdcPort() const { return _adcPort; }
+    Dac &getDac() { return _dac; }
+    Adc &getAdc() { return _adc; }
 
     void loadOS(const u8 *os) { _bus.loadRom(os, UMPK80_OS_SIZE); }
 
@@ -136,10 +391,15 @@ public:
 
     Cpu &getCpu() { return _intel8080; }
     Bus &getBus() { return _bus; }
+    // run() stops at them, hosts stepping the machine call check()
+    // on marked addresses
+    Breakpoints &getBreakpoints() { return _breakpoints; }
+    Scheduler &getScheduler() { return _scheduler; }
 
 private:
     Cpu _intel8080;
     Bus _bus;
+    Scheduler _scheduler;
 
     // Devices
     Keyboard _keyboard;
@@ -147,8 +407,54 @@ private:
     RegisterScanDevice _registerScan;
     RegisterDevice _register5In;
     RegisterDevice _register5Out;
+    Speaker _speaker;
 
     RegisterControlStep _registerStepExec;
+
+    // Expansion modules
+    Timer8253 _timer;
+    int _timerPort = -1;
+
+    Usart8251 _usart;
+    int _usartPort = -1;
+
+    Ppi8255 _ppi;
+    int _ppiPort = -1;
+
+    Printer _printer;
+    int _printerPort = -1;
+
+    Dac _dac;
+    int _dacPort = -1;
+
+    Adc _adc;
+    int _adcPort = -1;
+
+    struct KeyEvent {
+        u64 cycle;
+        KeyboardKey key;
+        bool pressed;
+    };
+
+    struct InterruptEvent {
+        u64 cycle;
+        u8 rstNum;
+    };
+
+    SpscRing<KeyEvent, UMPK80_KEY_QUEUE_SIZE> _keyEvents;
+    SpscRing<InterruptEvent, UMPK80_INTERRUPT_QUEUE_SIZE> _interruptEvents;
+    std::atomic_flag _interruptQueueLock = ATOMIC_FLAG_INIT;
+
+    // Set by the producers, the run loop stops at the next instruction
+    // boundary to look at the queues
+    std::atomic<bool> _eventsQueued{false};
+
+    // Per ROM address, the enabled HleRoutine at it plus one, 0 - none
+    u8 _hleAt[ROM_SIZE] = {0};
+
+    // HLE entries, breakpoints and the host's marks
+    AddressMarks _marks;
+    Breakpoints _breakpoints;
 public:
 #ifdef EMULATE_OLD_UMPK
     const u8 PORT_SPEAKER = 0x04;
@@ -164,6 +470,241 @@ public:
     const u8 PORT_SCAN     = 0x07;
 #endif
 private:
+    bool _step() {
+        u16 pc = _intel8080.getProgramCounter();
+
+        if (_marks.test(pc) && pc < ROM_SIZE && _hleAt[pc] != 0) {
+            return _runHle((HleRoutine)(_hleAt[pc] - 1));
+        }
+
+        _intel8080.tick();
+        return false;
+    }
+
+    // True when the handler returned to the caller, the decode one goes
+    // on to its CALL of the display scan instead
+    bool _runHle(HleRoutine routine) {
+        switch (routine) {
+        case HleRoutine::DisplayScan:   _scanDisplay();   return true;
+        case HleRoutine::Delay1ms:      _delay1ms();      return true;
+        case HleRoutine::Delay:         _delay();         return true;
+        case HleRoutine::Multiply:      _multiply();      return true;
+        case HleRoutine::DecodeMessage: _decodeMessage(); return false;
+        default:                        _intel8080.tick(); return false;
+        }
+    }
+
+    enum Event : u8 { EVENT_KEYS, EVENT_INTERRUPTS };
+
+    // Applies the queued key and interrupt events that are due and arms
+    // the scheduler for the next ones
+    void _applyQueuedEvents() {
+        // Cleared first, anything queued from now on sets it again.
+        // Acquire pairs with the producers' release, so the events behind
+        // a set flag are visible below.
+        _eventsQueued.exchange(false, std::memory_order_acquire);
+
+        KeyEvent key;
+
+        while (_keyEvents.peek(key)) {
+            if (key.cycle > _intel8080.getCycles()) {
+                _scheduler.post(key.cycle, *this, EVENT_KEYS);
+                break;
+            }
+
+            _keyEvents.pop(key);
+            key.pressed ? pressKey(key.key) : releaseKey(key.key);
+        }
+
+        InterruptEvent irq;
+
+        while (_interruptEvents.peek(irq)) {
+            if (irq.cycle > _intel8080.getCycles()) {
+                _scheduler.post(irq.cycle, *this, EVENT_INTERRUPTS);
+                break;
+            }
+
+            // The latch would merge it with the pending one, so it waits
+            // until the CPU has taken that
+            if (_intel8080.isInterruptPending(irq.rstNum)) {
+                _scheduler.post(_intel8080.getCycles() + 1, *this, EVENT_INTERRUPTS);
+                break;
+            }
+
+            _interruptEvents.pop(irq);
+            _intel8080.requestInterrupt(irq.rstNum);
+        }
+    }
+
+    void schedulerEvent(u8, u64) override { _applyQueuedEvents(); }
+
+    // Same port writes and timing as the routine at 01C8h, registers
+    // are preserved by the routine itself
+    void _scanDisplay() {
+        // PUSH PSW, H, B, then what the last digit's CALL 0429h leaves:
+        // its return address and the delay's PUSH B (B = 01h), PUSH PSW
+        // (A = 01h after XRA A) and PUSH D
+        _hlePushed(2, _psw());
+        _hlePushed(4, _registerPair(Cpu::Register::H, Cpu::Register::L));
+        _hlePushed(6, _registerPair(Cpu::Register::B, Cpu::Register::C));
+        _hlePushed(8, MONITOR_SCAN_DELAY_RETURN);
+        _hlePushed(10, 0x0100 | _intel8080.getRegister(Cpu::Register::C));
+        _hlePushed(12, 0x0100 | MONITOR_SCAN_DELAY_FLAGS);
+        _hlePushed(14, _registerPair(Cpu::Register::D, Cpu::Register::E));
+
+        _intel8080.addCycles(MONITOR_DISPLAY_SCAN_CYCLES);
+
+        for (int digit = 0; digit < 6; digit++) {
+            u16 adr = MONITOR_DISPLAY_BUFFER + 5 - digit;
+
+            _bus.portOut(PORT_SCAN, 0x00);
+            _bus.portOut(PORT_DISPLAY, _bus.memoryRead(adr));
+            _bus.portOut(PORT_SCAN, 0b100000 >> digit);
+        }
+
+        _bus.portOut(PORT_DISPLAY, 0x00);
+
+        _intel8080.forceReturn();
+    }
+
+    // What a routine's PUSH left `depth` bytes below the caller's SP
+    void _hlePushed(u16 depth, u16 value) {
+        u16 adr = _intel8080.getStackPointer() - depth;
+
+        _bus.memoryWrite(adr + 1, value >> 8);
+        _bus.memoryWrite(adr, value & 0xFF);
+    }
+
+    u16 _registerPair(Cpu::Register high, Cpu::Register low) const {
+        return ((u16)_intel8080.getRegister(high) << 8) | _intel8080.getRegister(low);
+    }
+
+    u16 _psw() const {
+        return ((u16)_intel8080.getRegister(Cpu::Register::A) << 8) | _intel8080.getRegisterFlags();
+    }
+
+    // 0429h: PUSH B, LXI B,1 and a jump into the BC ms delay
+    void _delay1ms() {
+        _hlePushed(2, _registerPair(Cpu::Register::B, Cpu::Register::C));
+        _delayLoop(1, 11 + 10 + 10);
+    }
+
+    // 0430h: BC (0 - 65536) times 103 DCR/JNZ rounds, every register
+    // is restored before returning
+    void _delay() {
+        u16 bc = _registerPair(Cpu::Register::B, Cpu::Register::C);
+
+        _hlePushed(2, bc);
+        _delayLoop(bc, 11);
+    }
+
+    void _delayLoop(u16 count, u32 entryCycles) {
+        _hlePushed(4, _psw());
+        _hlePushed(6, _registerPair(Cpu::Register::D, Cpu::Register::E));
+
+        u64 rounds = (count != 0) ? count : 0x10000;
+        // The last 256 rounds also compare C, B is zero by then
+        u64 lowRounds = (rounds < 256) ? rounds : 256;
+
+        // PUSH PSW, XRA, PUSH D; MVI, 103 * (DCR, JNZ), DCX, CMP, JNZ per
+        // round, CMP, JNZ when B is zero; POP D, POP PSW, POP B, RET
+        _intel8080.addCycles(entryCycles + 26 + rounds * 1571 + lowRounds * 14 + 40);
+        _intel8080.forceReturn();
+    }
+
+    // 04E1h: BC = D * E by shifting and adding over the 8 bits of E.
+    // A ends up 00h with the carry set, the other flags as they were
+    // after the routine's ANA A.
+    void _multiply() {
+        Cpu &cpu = _intel8080;
+
+        u8 multiplicand = cpu.getRegister(Cpu::Register::D);
+        u8 multiplier = cpu.getRegister(Cpu::Register::E);
+        u8 b = 0, c = 0;
+
+        // LXI B, MVI A, ANA A and RET, then 77 states per bit and 4 more
+        // for every ADD D
+        u32 cycles = 21 + 10;
+
+        for (int bit = 0; bit < 8; bit++) {
+            u16 sum = b;
+
+            if ((multiplier >> bit) & 1) {
+                sum += multiplicand;
+                cycles += 4;
+            }
+
+            // RAR B through the carry of the add, then RAR C through
+            // the bit shifted out of B
+            b = (u8)(sum >> 1);
+            c = (u8)((c >> 1) | ((sum & 1) << 7));
+            cycles += 77;
+        }
+
+        CpuFlagsMapping flags = cpu.getFlags();
+        flags.sign = 0;
+        flags.zero = 0;
+        flags.parity = 0;
+        flags.carry = 0;
+
+        // Last PUSH PSW, with the bit mask at 80h
+        cpu.setFlags(flags);
+        cpu.setRegister(Cpu::Register::A, 0x80);
+        _hlePushed(2, _psw());
+
+        flags.carry = 1;
+        cpu.setFlags(flags);
+        cpu.setRegister(Cpu::Register::A, 0x00);
+        cpu.setRegister(Cpu::Register::B, b);
+        cpu.setRegister(Cpu::Register::C, c);
+
+        cpu.addCycles(cycles);
+        cpu.forceReturn();
+    }
+
+    // 01E9h up to its CALL of the display scan, which runs as usual.
+    // Every register is restored by then.
+    void _decodeMessage() {
+        _hlePushed(2, _psw());
+        _hlePushed(4, _registerPair(Cpu::Register::B, Cpu::Register::C));
+        _hlePushed(6, _registerPair(Cpu::Register::D, Cpu::Register::E));
+        _hlePushed(8, _registerPair(Cpu::Register::H, Cpu::Register::L));
+        // PUSH D of the last lookup
+        _hlePushed(10, MONITOR_MESSAGE + 5);
+
+        for (int digit = 0; digit < 6; digit++) {
+            u8 code = _bus.memoryRead(MONITOR_MESSAGE + digit);
+
+            _bus.memoryWrite(MONITOR_DISPLAY_BUFFER + digit,
+                             _bus.memoryRead(MONITOR_SEGMENT_TABLE + code));
+        }
+
+        // PUSHes and LXIs, 94 states per digit, the dot test and POPs
+        u32 cycles = 64 + 6 * 94 + 31 + 40;
+
+        if (_bus.memoryRead(MONITOR_MESSAGE + 6) != 0) {
+            _bus.memoryWrite(MONITOR_DISPLAY_BUFFER,
+                             _bus.memoryRead(MONITOR_DISPLAY_BUFFER) | 0x80);
+            cycles += 21;
+        }
+
+        _intel8080.addCycles(cycles);
+        _intel8080.setProgramCounter(MONITOR_DECODE_SCAN_CALL);
+    }
+
+    // `count` ports from `basePort` with nothing bound in the
+    // directions a module uses
+    bool _portsFree(int basePort, int count, bool in, bool out) const {
+        if (basePort + count > PORTS_COUNT) return false;
+
+        for (int port = basePort; port < basePort + count; port++) {
+            if ((in && _bus.isPortBoundIn((u8)port)) || (out && _bus.isPortBoundOut((u8)port)))
+                return false;
+        }
+
+        return true;
+    }
+
     void _bindDevices() {
         _bus.portBindOut(PORT_SCAN, _registerScan);
 
@@ -173,6 +714,8 @@ private:
         _bus.portBindIn(PORT_IO, _register5In);
         _bus.portBindOut(PORT_IO, _register5Out);
 
+        _bus.portBindOut(PORT_SPEAKER, _speaker);
+
         _bus.portBindOut(0xE, _registerStepExec);
     }
 };
\ No newline at end of file
@@ -0,0 +1,247 @@
+#pragma once
+
+#include "bus.hpp"
+#include "cpu.hpp"
+#include "scheduler.hpp"
+
+#define USART_DEFAULT_BAUD 9600
+
+// Host side of the serial line. Called on the emulation thread,
+// implementations must not block.
+class SerialHost {
+public:
+    virtual void serialTransmit(u64 cycle, u8 data) = 0;
+
+    // False when no byte is available yet
+    virtual bool serialReceive(u8 &data) = 0;
+};
+
+// KR580VV51 (Intel 8251) USART, data register at base and
+// mode/command/status at base+1.
+// Characters take the time of a full frame at the configured baud rate:
+// the transmitter and the receiver are scheduler events, the status
+// register is only computed when it is read.
+class Usart8251 : public SchedulerClient {
+public:
+    Usart8251(Cpu &cpu, Scheduler &scheduler, u32 clockHz)
+        : _cpu(cpu), _scheduler(scheduler), _clockHz(clockHz),
+          _data(*this, false), _control(*this, true) {}
+
+    void bind(Bus &bus, u8 basePort) {
+        bus.portBindIn(basePort, _data);
+        bus.portBindOut(basePort, _data);
+        bus.portBindIn(basePort + 1, _control);
+        bus.portBindOut(basePort + 1, _control);
+    }
+
+    void unbind(Bus &bus, u8 basePort) {
+        bus.portUnbindIn(basePort, _data);
+        bus.portUnbindOut(basePort, _data);
+        bus.portUnbindIn(basePort + 1, _control);
+        bus.portUnbindOut(basePort + 1, _control);
+    }
+
+    void setBaudRate(u32 baud) { _baud = baud ? baud : USART_DEFAULT_BAUD; }
+    u32 getBaudRate() const { return _baud; }
+
+    void setHost(SerialHost *host) { _host = host; }
+
+    // RxRDY raises RST `rstNum`, -1 disconnects
+    void setInterrupt(int rstNum) { _rst = rstNum; }
+
+    void reset() {
+        _scheduler.cancel(*this, EVENT_TX);
+        _scheduler.cancel(*this, EVENT_RX);
+
+        _state = State::Mode;
+        _command = 0;
+        _status = STATUS_TXRDY | STATUS_TXEMPTY | STATUS_DSR;
+        _txFull = false;
+        _txBusy = false;
+    }
+
+    void schedulerEvent(u8 event, u64 cycle) override {
+        if (event == EVENT_TX) {
+            _txBusy = false;
+
+            if (_host != nullptr) _host->serialTransmit(cycle, _txShift);
+
+            _startTransmit(cycle);
+        } else {
+            _receive(cycle);
+        }
+    }
+
+private:
+    enum Event : u8 { EVENT_TX, EVENT_RX };
+
+    enum class State { Mode, Sync1, Sync2, Command };
+
+    static const u8 STATUS_TXRDY   = 0x01;
+    static const u8 STATUS_RXRDY   = 0x02;
+    static const u8 STATUS_TXEMPTY = 0x04;
+    static const u8 STATUS_PE      = 0x08;
+    static const u8 STATUS_OE      = 0x10;
+    static const u8 STATUS_FE      = 0x20;
+    static const u8 STATUS_DSR     = 0x80;
+
+    static const u8 COMMAND_TXEN  = 0x01;
+    static const u8 COMMAND_RXE   = 0x04;
+    static const u8 COMMAND_ER    = 0x10;
+    static const u8 COMMAND_IR    = 0x40;
+
+    class Port : public BusDeviceReadable, public BusDeviceWritable {
+    public:
+        Port(Usart8251 &usart, bool control) : _usart(usart), _isControl(control) {}
+
+        u8 busPortRead() override {
+            return _isControl ? _usart._readStatus() : _usart._readData();
+        }
+
+        void busPortWrite(u8 data) override {
+            _isControl ? _usart._writeControl(data) : _usart._writeData(data);
+        }
+
+    private:
+        Usart8251 &_usart;
+        bool _isControl;
+    };
+
+    Cpu &_cpu;
+    Scheduler &_scheduler;
+    u32 _clockHz;
+    u32 _baud = USART_DEFAULT_BAUD;
+
+    Port _data;
+    Port _control;
+
+    SerialHost *_host = nullptr;
+    int _rst = -1;
+
+    State _state = State::Mode;
+    u8 _mode = 0x4E;            // Async x16, 8 bits, no parity, 1 stop bit
+    u8 _command = 0;
+    u8 _status = STATUS_TXRDY | STATUS_TXEMPTY | STATUS_DSR;
+
+    u8 _txHold = 0;
+    u8 _txShift = 0;
+    bool _txFull = false;       // Holding register waits for the shifter
+    bool _txBusy = false;       // Frame on the line
+
+    u8 _rxData = 0;
+
+    u8 _readStatus() const { return _status; }
+
+    u8 _readData() {
+        _status &= ~STATUS_RXRDY;
+        return _rxData;
+    }
+
+    void _writeData(u8 data) {
+        _txHold = data & _dataMask();
+        _txFull = true;
+        _status &= ~(STATUS_TXRDY | STATUS_TXEMPTY);
+
+        _startTransmit(_cpu.getCycles());
+    }
+
+    void _writeControl(u8 data) {
+        switch (_state) {
+        case State::Mode:
+            _mode = data;
+
+            // Synchronous mode is followed by one or two sync characters
+            if ((_mode & 0x03) == 0) {
+                _state = State::Sync1;
+            } else {
+                _state = State::Command;
+            }
+            break;
+
+        case State::Sync1:
+            _state = (_mode & 0x80) ? State::Command : State::Sync2;
+            break;
+
+        case State::Sync2:
+            _state = State::Command;
+            break;
+
+        case State::Command:
+            _writeCommand(data);
+            break;
+        }
+    }
+
+    void _writeCommand(u8 data) {
+        if (data & COMMAND_IR) {
+            reset();
+            return;
+        }
+
+        bool rxWasEnabled = (_command & COMMAND_RXE) != 0;
+
+        _command = data;
+
+        if (data & COMMAND_ER) _status &= ~(STATUS_PE | STATUS_OE | STATUS_FE);
+
+        if (data & COMMAND_TXEN) _startTransmit(_cpu.getCycles());
+
+        // The receiver samples the line once per frame while enabled
+        if ((data & COMMAND_RXE) && !rxWasEnabled) {
+            _scheduler.post(_cpu.getCycles() + _frameCycles(), *this, EVENT_RX);
+        } else if (!(data & COMMAND_RXE)) {
+            _scheduler.cancel(*this, EVENT_RX);
+        }
+    }
+
+    // Moves the holding register into the shifter when the line is free
+    void _startTransmit(u64 cycle) {
+        if (_txBusy) return;
+
+        if (!_txFull || !(_command & COMMAND_TXEN)) {
+            if (!_txFull) _status |= STATUS_TXEMPTY;
+            return;
+        }
+
+        _txShift = _txHold;
+        _txFull = false;
+        _txBusy = true;
+        _status |= STATUS_TXRDY;
+
+        _scheduler.post(cycle + _frameCycles(), *this, EVENT_TX);
+    }
+
+    void _receive(u64 cycle) {
+        u8 data;
+
+        if (_host != nullptr && _host->serialReceive(data)) {
+            if (_status & STATUS_RXRDY) _status |= STATUS_OE;
+
+            _rxData = data & _dataMask();
+            _status |= STATUS_RXRDY;
+
+            if (_rst >= 0) _cpu.requestInterrupt(_rst);
+        }
+
+        if (_command & COMMAND_RXE) _scheduler.post(cycle + _frameCycles(), *this, EVENT_RX);
+    }
+
+    u8 _dataMask() const { return 0xFF >> (3 - ((_mode >> 2) & 0x03)); }
+
+    // Start bit, data bits, parity and stop bits at the baud rate
+    u64 _frameCycles() const {
+        u32 halfBits = 2 * (1 + 5 + ((_mode >> 2) & 0x03));
+
+        if (_mode & 0x10) halfBits += 2;
+
+        if ((_mode & 0x03) != 0) {
+            static const u8 stopHalfBits[4] = {2, 2, 3, 4};
+            halfBits += stopHalfBits[(_mode >> 6) & 0x03];
+        } else {
+            // Synchronous frames have no start and stop bits
+            halfBits -= 2;
+        }
+
+        return (u64)_clockHz * halfBits / (2 * (u64)_baud);
+    }
+};
@@ -29,6 +29,15 @@ extern "C" {
         M
     };
 
+    // Same order as HleRoutine
+    enum UMPK80_HleRoutine {
+        HLE_DISPLAY_SCAN,       // 01C8h
+        HLE_DELAY_1MS,          // 0429h
+        HLE_DELAY,              // 0430h
+        HLE_MULTIPLY,           // 04E1h
+        HLE_DECODE_MESSAGE,     // 01E9h
+    };
+
     enum UMPK80_RegisterPair {
         PC,
         SP,
@@ -47,15 +56,102 @@ extern "C" {
     u8 UMPK80_PortIOGetOutput(UMPK80_t umpk);
 
     void    UMPK80_Tick(UMPK80_t umpk);
+    // True when a breakpoint stopped it before `cycles`
+    bool    UMPK80_Run(UMPK80_t umpk, u64 cycles);
+    u64     UMPK80_Cycles(UMPK80_t umpk);
     void    UMPK80_Stop(UMPK80_t umpk);
     void    UMPK80_Restart(UMPK80_t umpk);
+    // Requests RST `rstNum` on INTR at `cycle` (0 - next instruction), taken
+    // once interrupts are enabled. Callable from any thread, false when
+    // the queue is full.
+    bool    UMPK80_QueueInterrupt(UMPK80_t umpk, u8 rstNum, u64 cycle);
 
     void    UMPK80_KeyboardPressButton(UMPK80_t umpk, u8 key);
     void    UMPK80_KeyboardReleaseButton(UMPK80_t umpk, u8 key);
+    bool    UMPK80_KeyboardQueueEvent(UMPK80_t umpk, u8 key, bool pressed, u64 cycle);
+
+    // The *SetPort calls return false, keeping the old mapping, when a port
+    // is taken by a built-in device or another module. -1 unmaps.
+    bool    UMPK80_TimerSetPort(UMPK80_t umpk, int basePort);
+    void    UMPK80_TimerSetClockDivider(UMPK80_t umpk, u32 cycles);
+    void    UMPK80_TimerSetInterrupt(UMPK80_t umpk, u8 counter, int rstNum);
+    void    UMPK80_TimerSetGate(UMPK80_t umpk, u8 counter, bool level);
+    bool    UMPK80_TimerGetOutput(UMPK80_t umpk, u8 counter);
+
+    bool    UMPK80_UsartSetPort(UMPK80_t umpk, int basePort);
+    void    UMPK80_UsartSetBaudRate(UMPK80_t umpk, u32 baud);
+    void    UMPK80_UsartSetInterrupt(UMPK80_t umpk, int rstNum);
+    // Host side of the serial line, both are called on the emulating thread.
+    // `receive` returns false when no byte is available. NULL disconnects.
+    typedef void (*UMPK80_SerialTransmit_t)(void* user, u64 cycle, u8 data);
+    typedef bool (*UMPK80_SerialReceive_t)(void* user, u8* data);
+
+    void    UMPK80_UsartSetHost(UMPK80_t umpk, UMPK80_SerialTransmit_t transmit,
+                                UMPK80_SerialReceive_t receive, void* user);
+
+    // Called on the emulating thread whenever the pins of a port change
+    typedef void (*UMPK80_PpiListener_t)(void* user, u8 port, u64 cycle, u8 pins);
+
+    bool    UMPK80_PpiSetPort(UMPK80_t umpk, int basePort);
+    void    UMPK80_PpiSetInput(UMPK80_t umpk, u8 port, u8 value);
+    u8      UMPK80_PpiGetPins(UMPK80_t umpk, u8 port);
+    void    UMPK80_PpiStrobe(UMPK80_t umpk, u8 port, u8 data, u64 delay);
+    void    UMPK80_PpiAcknowledge(UMPK80_t umpk, u8 port);
+    void    UMPK80_PpiSetAutoAcknowledge(UMPK80_t umpk, u8 port, u32 cycles);
+    void    UMPK80_PpiSetInterrupt(UMPK80_t umpk, u8 port, int rstNum);
+    void    UMPK80_PpiSetListener(UMPK80_t umpk, UMPK80_PpiListener_t listener, void* user);
+
+    bool    UMPK80_PrinterSetPort(UMPK80_t umpk, int basePort);
+    // Takes up to `size` printed bytes, lock-free: one thread may drain
+    // the printer while another one runs the emulation
+    u32     UMPK80_PrinterRead(UMPK80_t umpk, u8* buffer, u32 size);
+    u64     UMPK80_PrinterDropped(UMPK80_t umpk);
+
+    bool    UMPK80_DacSetPort(UMPK80_t umpk, int port);
+    // Takes up to `size` of the oldest DAC writes into the cycle and value
+    // columns, lock-free like UMPK80_PrinterRead
+    u32     UMPK80_DacRead(UMPK80_t umpk, u64* cycles, u8* values, u32 size);
+    u64     UMPK80_DacDropped(UMPK80_t umpk);
+
+    // Called on the emulating thread for every ADC conversion. NULL disconnects.
+    typedef u8 (*UMPK80_AdcSource_t)(void* user, u64 cycle);
+
+    bool    UMPK80_AdcSetPort(UMPK80_t umpk, int port);
+    void    UMPK80_AdcSetSource(UMPK80_t umpk, UMPK80_AdcSource_t source, void* user);
 
     u8 UMPK80_DisplayGetDigit(UMPK80_t umpk, int digit);
+    u8 UMPK80_DisplayGetBrightness(UMPK80_t umpk, int digit);
+    void    UMPK80_DisplaySetPersistence(UMPK80_t umpk, u32 cycles);
+    void    UMPK80_DisplaySetFastPath(UMPK80_t umpk, bool enabled);
+    // Runs a monitor routine at a high level (true) or as the ROM code
+    void    UMPK80_SetHle(UMPK80_t umpk, int routine, bool enabled);
+    bool    UMPK80_IsHle(UMPK80_t umpk, int routine);
     void    UMPK80_LoadOS(UMPK80_t umpk, const u8* os);
 
+    // Breakpoint before the instruction at `adr`, UMPK80_Run stops on its
+    // `hits`-th pass with `condition` true (NULL or "" - always, e.g.
+    // "A == 3F && [0BF0] != 0") and on every one after it. A log-only one
+    // calls the log callback instead. Returns the id, 0 when the condition
+    // doesn't parse or there are too many breakpoints.
+    int     UMPK80_BreakpointAdd(UMPK80_t umpk, u16 adr, const char* condition, u32 hits,
+                                 bool logOnly);
+    bool    UMPK80_BreakpointRemove(UMPK80_t umpk, int id);
+    bool    UMPK80_BreakpointSetEnabled(UMPK80_t umpk, int id, bool enabled);
+    // Passes with the condition true so far, 0 for an unknown id
+    u32     UMPK80_BreakpointHits(UMPK80_t umpk, int id);
+    // Id of the breakpoint that stopped the last run, 0 - none
+    int     UMPK80_BreakpointStoppedBy(UMPK80_t umpk);
+
+    // Called on the emulating thread when a log-only breakpoint acts.
+    // NULL disconnects.
+    typedef void (*UMPK80_BreakpointLog_t)(void* user, int id, u16 adr, u32 hits);
+
+    void    UMPK80_BreakpointSetLog(UMPK80_t umpk, UMPK80_BreakpointLog_t log, void* user);
+
+    // Evaluates a breakpoint condition style expression on the current
+    // state, false when it doesn't compile
+    bool    UMPK80_Evaluate(UMPK80_t umpk, const char* expression, u64* value);
+
     void    UMPK80_LoadProgram(UMPK80_t umpk, const u8* program, u16 programSize, u16 dstAddress);
 
     u16 UMPK80_CpuProgramCounter(UMPK80_t umpk);
@@ -74,6 +170,7 @@ extern "C" {
 
     u8 UMPK80_MemoryRead(UMPK80_t umpk, u16 adr);
     void    UMPK80_MemoryWrite(UMPK80_t umpk, u16 adr, u8 data);
+    void    UMPK80_MemoryAttach(UMPK80_t umpk, u8* storage);
 
     const UMPK80_Instruction_t* UMPK80_GetInstruction(u8 code);
 
@@ -86,15 +183,69 @@ extern "C" {
 }
 
 
+class CallbackSerialHost : public SerialHost {
+public:
+    UMPK80_SerialTransmit_t transmit = nullptr;
+    UMPK80_SerialReceive_t receive = nullptr;
+    void* user = nullptr;
+
+    void serialTransmit(u64 cycle, u8 data) override {
+        if (transmit) transmit(user, cycle, data);
+    }
+
+    bool serialReceive(u8& data) override {
+        return receive && receive(user, &data);
+    }
+};
+
+class CallbackPpiListener : public PpiListener {
+public:
+    UMPK80_PpiListener_t listener = nullptr;
+    void* user = nullptr;
+
+    void ppiPortChanged(u8 port, u64 cycle, u8 pins) override {
+        listener(user, port, cycle, pins);
+    }
+};
+
+class CallbackAnalogSource : public AnalogSource {
+public:
+    UMPK80_AdcSource_t source = nullptr;
+    void* user = nullptr;
+
+    u8 analogSample(u64 cycle) override {
+        return source(user, cycle);
+    }
+};
+
+class CallbackBreakpointListener : public BreakpointListener {
+public:
+    UMPK80_BreakpointLog_t log = nullptr;
+    void* user = nullptr;
+
+    void breakpointLogged(const Breakpoint& breakpoint) override {
+        log(user, breakpoint.id, breakpoint.address, breakpoint.hits);
+    }
+};
+
+// State of the C API that lives next to the emulator
+struct Umpk80Instance {
+    Umpk80 umpk;
+    CallbackSerialHost serialHost;
+    CallbackPpiListener ppiListener;
+    CallbackAnalogSource adcSource;
+    CallbackBreakpointListener breakpointLog;
+};
+
 UMPK80_t UMPK80_Create() {
-    return new Umpk80();
+    return new Umpk80Instance();
 }
 
 void UMPK80_Free(UMPK80_t umpk) {
-    delete (Umpk80*)umpk;
+    delete (Umpk80Instance*)umpk;
 }
 
-static Umpk80* inst(UMPK80_t umpk) { return (Umpk80*)umpk; }
+static Umpk80* inst(UMPK80_t umpk) { return &((Umpk80Instance*)umpk)->umpk; }
 
 void UMPK80_PortIOSetInput(UMPK80_t umpk, u8 data) {
     inst(umpk)->port5InSet(data); 
@@ -112,6 +263,14 @@ void UMPK80_Tick(UMPK80_t umpk) {
     inst(umpk)->tick();
 }
 
+bool UMPK80_Run(UMPK80_t umpk, u64 cycles) {
+    return inst(umpk)->run(cycles);
+}
+
+u64 UMPK80_Cycles(UMPK80_t umpk) {
+    return inst(umpk)->getCycles();
+}
+
 void UMPK80_Stop(UMPK80_t umpk) {
     inst(umpk)->stop();
 }
@@ -120,6 +279,10 @@ void UMPK80_Restart(UMPK80_t umpk) {
     inst(umpk)->restart();
 }
 
+bool UMPK80_QueueInterrupt(UMPK80_t umpk, u8 rstNum, u64 cycle) {
+    return inst(umpk)->queueInterrupt(rstNum, cycle);
+}
+
 void UMPK80_KeyboardPressButton(UMPK80_t umpk, u8 key) {
     inst(umpk)->pressKey((KeyboardKey)key);
 }
@@ -128,14 +291,206 @@ void UMPK80_KeyboardReleaseButton(UMPK80_t umpk, u8 key) {
     inst(umpk)->releaseKey((KeyboardKey)key);
 }
 
+bool UMPK80_KeyboardQueueEvent(UMPK80_t umpk, u8 key, bool pressed, u64 cycle) {
+    return inst(umpk)->queueKey((KeyboardKey)key, pressed, cycle);
+}
+
+bool UMPK80_TimerSetPort(UMPK80_t umpk, int basePort) {
+    return inst(umpk)->setTimerPort(basePort);
+}
+
+void UMPK80_TimerSetClockDivider(UMPK80_t umpk, u32 cycles) {
+    inst(umpk)->getTimer().setClockDivider(cycles);
+}
+
+void UMPK80_TimerSetInterrupt(UMPK80_t umpk, u8 counter, int rstNum) {
+    if (counter < TIMER_COUNTERS) inst(umpk)->getTimer().setInterrupt(counter, rstNum);
+}
+
+void UMPK80_TimerSetGate(UMPK80_t umpk, u8 counter, bool level) {
+    if (counter < TIMER_COUNTERS) inst(umpk)->getTimer().setGate(counter, level);
+}
+
+bool UMPK80_TimerGetOutput(UMPK80_t umpk, u8 counter) {
+    return (counter < TIMER_COUNTERS) ? inst(umpk)->getTimer().getOutput(counter) : false;
+}
+
+bool UMPK80_UsartSetPort(UMPK80_t umpk, int basePort) {
+    return inst(umpk)->setUsartPort(basePort);
+}
+
+void UMPK80_UsartSetBaudRate(UMPK80_t umpk, u32 baud) {
+    inst(umpk)->getUsart().setBaudRate(baud);
+}
+
+void UMPK80_UsartSetInterrupt(UMPK80_t umpk, int rstNum) {
+    inst(umpk)->getUsart().setInterrupt(rstNum);
+}
+
+void UMPK80_UsartSetHost(UMPK80_t umpk, UMPK80_SerialTransmit_t transmit,
+                         UMPK80_SerialReceive_t receive, void* user) {
+    CallbackSerialHost& host = ((Umpk80Instance*)umpk)->serialHost;
+
+    host.transmit = transmit;
+    host.receive = receive;
+    host.user = user;
+
+    inst(umpk)->getUsart().setHost((transmit || receive) ? &host : nullptr);
+}
+
+bool UMPK80_PpiSetPort(UMPK80_t umpk, int basePort) {
+    return inst(umpk)->setPpiPort(basePort);
+}
+
+void UMPK80_PpiSetInput(UMPK80_t umpk, u8 port, u8 value) {
+    inst(umpk)->getPpi().setInput(port, value);
+}
+
+u8 UMPK80_PpiGetPins(UMPK80_t umpk, u8 port) {
+    return inst(umpk)->getPpi().getPins(port);
+}
+
+void UMPK80_PpiStrobe(UMPK80_t umpk, u8 port, u8 data, u64 delay) {
+    inst(umpk)->getPpi().strobe(port, data, delay);
+}
+
+void UMPK80_PpiAcknowledge(UMPK80_t umpk, u8 port) {
+    inst(umpk)->getPpi().acknowledge(port);
+}
+
+void UMPK80_PpiSetAutoAcknowledge(UMPK80_t umpk, u8 port, u32 cycles) {
+    inst(umpk)->getPpi().setAutoAcknowledge(port, cycles);
+}
+
+void UMPK80_PpiSetInterrupt(UMPK80_t umpk, u8 port, int rstNum) {
+    inst(umpk)->getPpi().setInterrupt(port, rstNum);
+}
+
+void UMPK80_PpiSetListener(UMPK80_t umpk, UMPK80_PpiListener_t listener, void* user) {
+    CallbackPpiListener& adapter = ((Umpk80Instance*)umpk)->ppiListener;
+
+    adapter.listener = listener;
+    adapter.user = user;
+
+    inst(umpk)->getPpi().setListener(listener ? &adapter : nullptr);
+}
+
+bool UMPK80_PrinterSetPort(UMPK80_t umpk, int basePort) {
+    return inst(umpk)->setPrinterPort(basePort);
+}
+
+u32 UMPK80_PrinterRead(UMPK80_t umpk, u8* buffer, u32 size) {
+    Printer& printer = inst(umpk)->getPrinter();
+    u32 count = 0;
+
+    while (count < size && printer.take(buffer[count])) count++;
+
+    return count;
+}
+
+u64 UMPK80_PrinterDropped(UMPK80_t umpk) {
+    return inst(umpk)->getPrinter().dropped();
+}
+
+bool UMPK80_DacSetPort(UMPK80_t umpk, int port) {
+    return inst(umpk)->setDacPort(port);
+}
+
+u32 UMPK80_DacRead(UMPK80_t umpk, u64* cycles, u8* values, u32 size) {
+    return inst(umpk)->getDac().getTrace().read(cycles, values, size);
+}
+
+u64 UMPK80_DacDropped(UMPK80_t umpk) {
+    return inst(umpk)->getDac().dropped();
+}
+
+bool UMPK80_AdcSetPort(UMPK80_t umpk, int port) {
+    return inst(umpk)->setAdcPort(port);
+}
+
+void UMPK80_AdcSetSource(UMPK80_t umpk, UMPK80_AdcSource_t source, void* user) {
+    CallbackAnalogSource& adapter = ((Umpk80Instance*)umpk)->adcSource;
+
+    adapter.source = source;
+    adapter.user = user;
+
+    inst(umpk)->getAdc().setSource(source ? &adapter : nullptr);
+}
+
 u8 UMPK80_DisplayGetDigit(UMPK80_t umpk, int digit) {
     return inst(umpk)->getDisplayDigit(digit);
 }
 
+u8 UMPK80_DisplayGetBrightness(UMPK80_t umpk, int digit) {
+    return inst(umpk)->getDisplayBrightness(digit);
+}
+
+void UMPK80_DisplaySetPersistence(UMPK80_t umpk, u32 cycles) {
+    inst(umpk)->setDisplayPersistence(cycles);
+}
+
+void UMPK80_DisplaySetFastPath(UMPK80_t umpk, bool enabled) {
+    inst(umpk)->setDisplayFastPath(enabled);
+}
+
+void UMPK80_SetHle(UMPK80_t umpk, int routine, bool enabled) {
+    if (routine < 0 || routine >= (int)HleRoutine::Count) return;
+
+    inst(umpk)->setHle((HleRoutine)routine, enabled);
+}
+
+bool UMPK80_IsHle(UMPK80_t umpk, int routine) {
+    if (routine < 0 || routine >= (int)HleRoutine::Count) return false;
+
+    return inst(umpk)->isHle((HleRoutine)routine);
+}
+
 void UMPK80_LoadOS(UMPK80_t umpk, const u8* os) {
     inst(umpk)->loadOS(os);
 }
 
+int UMPK80_BreakpointAdd(UMPK80_t umpk, u16 adr, const char* condition, u32 hits, bool logOnly) {
+    return inst(umpk)->getBreakpoints().add(adr, condition, hits, logOnly);
+}
+
+bool UMPK80_BreakpointRemove(UMPK80_t umpk, int id) {
+    return inst(umpk)->getBreakpoints().remove(id);
+}
+
+bool UMPK80_BreakpointSetEnabled(UMPK80_t umpk, int id, bool enabled) {
+    return inst(umpk)->getBreakpoints().setEnabled(id, enabled);
+}
+
+u32 UMPK80_BreakpointHits(UMPK80_t umpk, int id) {
+    const Breakpoint* breakpoint = inst(umpk)->getBreakpoints().find(id);
+
+    return breakpoint ? breakpoint->hits : 0;
+}
+
+int UMPK80_BreakpointStoppedBy(UMPK80_t umpk) {
+    return inst(umpk)->getBreakpoints().stoppedBy();
+}
+
+void UMPK80_BreakpointSetLog(UMPK80_t umpk, UMPK80_BreakpointLog_t log, void* user) {
+    CallbackBreakpointListener& adapter = ((Umpk80Instance*)umpk)->breakpointLog;
+
+    adapter.log = log;
+    adapter.user = user;
+
+    inst(umpk)->getBreakpoints().setListener(log ? &adapter : nullptr);
+}
+
+bool UMPK80_Evaluate(UMPK80_t umpk, const char* expression, u64* value) {
+    Expression compiled;
+
+    if (!compiled.compile(expression)) return false;
+
+    CpuBusView view(inst(umpk)->getCpu(), inst(umpk)->getBus());
+    *value = compiled.evaluate(view);
+
+    return true;
+}
+
 u16 UMPK80_CpuProgramCounter(UMPK80_t umpk) {
     return inst(umpk)->getCpu().getProgramCounter();
 }
@@ -220,6 +575,10 @@ void UMPK80_MemoryWrite(UMPK80_t umpk, u16 adr, u8 data) {
     inst(umpk)->getBus().memoryWrite(adr, data);
 }
 
+void UMPK80_MemoryAttach(UMPK80_t umpk, u8* storage) {
+    inst(umpk)->getBus().memoryAttach(storage);
+}
+
 void UMPK80_LoadProgram(UMPK80_t umpk, const u8* program, u16 programSize, u16 dstAddress) {
     inst(umpk)->getBus().loadRam(program, programSize, dstAddress);
 }
@@ -0,0 +1,161 @@
+#include "analog-stream.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "controller.hpp"
+#include "host-thread.hpp"
+
+static const uint32_t BLOCK_SIZE = 4096;
+
+// How long the thread sleeps on an empty trace before looking again
+static const int IDLE_MS = 2;
+
+static const double PI = 3.14159265358979323846;
+
+DacRecorder::DacRecorder(Dac& dac, const std::string& path)
+    : _dac(dac), _history(HISTORY_SIZE, 0.0f) {
+    if (!path.empty()) {
+        _file.open(path, HostFile::Mode::Write);
+
+        _csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+
+        if (_csv) {
+            static const char header[] = "cycle,value\n";
+            _file.writeBlock((const uint8_t*)header, sizeof(header) - 1);
+        }
+    }
+
+    // Started last, it uses everything above
+    _thread = std::thread(&DacRecorder::_work, this);
+}
+
+DacRecorder::~DacRecorder() {
+    _running.store(false, std::memory_order_release);
+    _thread.join();
+}
+
+void DacRecorder::getHistory(std::vector<float>& values) {
+    std::lock_guard<std::mutex> lock(_historyMutex);
+
+    values.assign(_history.begin() + _historyPos, _history.end());
+    values.insert(values.end(), _history.begin(), _history.begin() + _historyPos);
+}
+
+void DacRecorder::_work() {
+    setHostThreadName("umpk-dac");
+
+    u64 cycles[BLOCK_SIZE];
+    uint8_t values[BLOCK_SIZE];
+
+    for (;;) {
+        // Checked before draining, so every write made before the
+        // destructor ran still gets out
+        bool running = _running.load(std::memory_order_acquire);
+
+        uint32_t count = _dac.getTrace().read(cycles, values, BLOCK_SIZE);
+
+        if (count == 0) {
+            if (!running) return;
+            std::this_thread::sleep_for(std::chrono::milliseconds(IDLE_MS));
+            continue;
+        }
+
+        if (_file.isOpen()) {
+            if (_csv) _writeCsv(cycles, values, count);
+            else _writeBinary(cycles, values, count);
+        }
+
+        _samples.fetch_add(count, std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(_historyMutex);
+        for (uint32_t i = 0; i < count; i++) {
+            _history[_historyPos] = values[i];
+            _historyPos = (_historyPos + 1) % HISTORY_SIZE;
+        }
+    }
+}
+
+void DacRecorder::_writeCsv(const u64* cycles, const uint8_t* values, uint32_t count) {
+    std::string text;
+    char line[32];
+
+    for (uint32_t i = 0; i < count; i++) {
+        int n = snprintf(line, sizeof(line), "%llu,%u\n", (unsigned long long)cycles[i], values[i]);
+        text.append(line, n);
+    }
+
+    _file.writeBlock((const uint8_t*)text.data(), text.size());
+}
+
+void DacRecorder::_writeBinary(const u64* cycles, const uint8_t* values, uint32_t count) {
+    std::vector<uint8_t> block(4 + count * 9);
+    uint8_t* p = block.data();
+
+    for (int i = 0; i < 4; i++) *p++ = (count >> (i * 8)) & 0xFF;
+
+    for (uint32_t i = 0; i < count; i++) {
+        for (int b = 0; b < 8; b++) *p++ = (cycles[i] >> (b * 8)) & 0xFF;
+    }
+
+    for (uint32_t i = 0; i < count; i++) *p++ = values[i];
+
+    _file.writeBlock(block.data(), block.size());
+}
+
+WaveformSource* WaveformSource::fromSpec(const std::string& spec, uint32_t clockHz) {
+    size_t colon = spec.find(':');
+    std::string name = spec.substr(0, colon);
+    double frequency = (colon == std::string::npos) ? 0 : std::atof(spec.c_str() + colon + 1);
+
+    Shape shape;
+
+    if (name == "sine") shape = Shape::Sine;
+    else if (name == "square") shape = Shape::Square;
+    else if (name == "saw") shape = Shape::Sawtooth;
+    else if (name == "triangle") shape = Shape::Triangle;
+    else throw std::runtime_error("Unknown waveform \"" + name + "\"");
+
+    if (frequency <= 0) throw std::runtime_error("Bad waveform frequency in \"" + spec + "\"");
+
+    return new WaveformSource(shape, frequency, clockHz);
+}
+
+u8 WaveformSource::analogSample(u64 cycle) {
+    double periods = (double)cycle * _frequency / _clockHz;
+    double phase = periods - std::floor(periods);
+    double level;
+
+    switch (_shape) {
+    case Shape::Sine:     level = 0.5 + 0.5 * std::sin(2 * PI * phase); break;
+    case Shape::Square:   level = (phase < 0.5) ? 1.0 : 0.0;            break;
+    case Shape::Sawtooth: level = phase;                                 break;
+    default:              level = 1.0 - std::fabs(2 * phase - 1.0);      break;
+    }
+
+    return (u8)(level * 255 + 0.5);
+}
+
+SampleFileSource::SampleFileSource(const std::string& path, uint32_t sampleRate,
+                                   uint32_t clockHz)
+    : _samples(Controller::readBinaryFile(path)),
+      _sampleRate(sampleRate ? sampleRate : 1), _clockHz(clockHz) {
+    if (_samples.empty()) throw std::runtime_error(path + " has no samples");
+}
+
+u8 SampleFileSource::analogSample(u64 cycle) {
+    u64 index = cycle * _sampleRate / _clockHz;
+
+    return _samples[index % _samples.size()];
+}
+
+AnalogSource* createAnalogSource(const std::string& file, uint32_t sampleRate,
+                                 const std::string& wave, uint32_t clockHz) {
+    if (!file.empty()) return new SampleFileSource(file, sampleRate, clockHz);
+    if (!wave.empty()) return WaveformSource::fromSpec(wave, clockHz);
+
+    return nullptr;
+}
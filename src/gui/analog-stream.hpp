@@ -0,0 +1,99 @@
+#ifndef UMPK_80_EMU_UI_ANALOG_STREAM_HPP
+#define UMPK_80_EMU_UI_ANALOG_STREAM_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../core/analog.hpp"
+
+#include "host-stream.hpp"
+
+// Drains the DAC trace on a background thread into a file and keeps the
+// latest values for the GUI plot.
+// A path ending in ".csv" gets "cycle,value" lines, any other path gets
+// binary blocks: u32 count, count u64 cycles, count u8 values, all
+// little-endian. An empty path only keeps the plot.
+// Throws std::runtime_error if the file can't be opened.
+class DacRecorder {
+public:
+    // Values kept for the plot
+    static const size_t HISTORY_SIZE = 1024;
+
+    // `dac` must outlive the recorder
+    DacRecorder(Dac& dac, const std::string& path);
+
+    // Whatever the trace still holds is written out first
+    ~DacRecorder();
+
+    uint64_t samples() const { return _samples.load(std::memory_order_relaxed); }
+
+    // Latest values, oldest first
+    void getHistory(std::vector<float>& values);
+
+    const std::string& fileName() const { return _file.name(); }
+
+private:
+    Dac& _dac;
+    HostFile _file;
+    bool _csv = false;
+
+    std::mutex _historyMutex;
+    std::vector<float> _history;
+    size_t _historyPos = 0;
+
+    std::atomic<uint64_t> _samples{0};
+    std::atomic<bool> _running{true};
+    std::thread _thread;
+
+    void _work();
+    void _writeCsv(const u64* cycles, const uint8_t* values, uint32_t count);
+    void _writeBinary(const u64* cycles, const uint8_t* values, uint32_t count);
+};
+
+// Periodic test signal for the ADC, a function of the cycle,
+// so it follows emulated time whatever the host speed
+class WaveformSource : public AnalogSource {
+public:
+    enum class Shape { Sine, Square, Sawtooth, Triangle };
+
+    WaveformSource(Shape shape, double frequency, uint32_t clockHz)
+        : _shape(shape), _frequency(frequency), _clockHz(clockHz) {}
+
+    // "<shape>:<Hz>" with sine, square, saw or triangle.
+    // Throws std::runtime_error on a bad spec.
+    static WaveformSource* fromSpec(const std::string& spec, uint32_t clockHz);
+
+    u8 analogSample(u64 cycle) override;
+
+private:
+    Shape _shape;
+    double _frequency;
+    uint32_t _clockHz;
+};
+
+// Unsigned 8-bit samples from a raw file at `sampleRate`, looped.
+// The file is read up front, a conversion is only an index.
+// Throws std::runtime_error if it can't be read or is empty.
+class SampleFileSource : public AnalogSource {
+public:
+    SampleFileSource(const std::string& path, uint32_t sampleRate, uint32_t clockHz);
+
+    u8 analogSample(u64 cycle) override;
+
+private:
+    std::vector<uint8_t> _samples;
+    uint32_t _sampleRate;
+    uint32_t _clockHz;
+};
+
+// ADC input from a sample file when `file` is set, otherwise from the
+// `wave` spec, nullptr when neither is.
+// Throws std::runtime_error if the source can't be made.
+AnalogSource* createAnalogSource(const std::string& file, uint32_t sampleRate,
+                                 const std::string& wave, uint32_t clockHz);
+
+#endif // UMPK_80_EMU_UI_ANALOG_STREAM_HPP
@@ -0,0 +1,50 @@
+#ifndef UI_ANALOG_HPP
+#define UI_ANALOG_HPP
+
+#include <imgui.h>
+#include <vector>
+
+#include "../irenderable.hpp"
+#include "../../controller.hpp"
+
+class UiAnalog : public IRenderable {
+public:
+    UiAnalog(Controller& controller) : m_controller(controller) {}
+
+    void render() override {
+        DacRecorder* recorder = m_controller.dacRecorder();
+        const MachineSnapshot& snapshot = m_controller.snapshot();
+
+        if (recorder == nullptr) {
+            ImGui::TextUnformatted("DAC is not connected (--dac <hex port>)");
+        } else {
+            ImGui::Text("DAC P%02X = %02X, %llu writes", snapshot.dacPort, snapshot.dacValue,
+                        (unsigned long long)recorder->samples());
+
+            if (!recorder->fileName().empty()) {
+                ImGui::SameLine();
+                ImGui::Text("to %s", recorder->fileName().c_str());
+            }
+
+            recorder->getHistory(m_history);
+
+            ImGui::PlotLines("##dac", m_history.data(), (int)m_history.size(), 0, nullptr,
+                             0.0f, 255.0f, ImVec2(-1, 150));
+        }
+
+        ImGui::Separator();
+
+        if (snapshot.adcPort < 0) {
+            ImGui::TextUnformatted("ADC is not connected (--adc <hex port>)");
+        } else {
+            ImGui::Text("ADC P%02X", snapshot.adcPort);
+        }
+    }
+
+private:
+    Controller& m_controller;
+
+    std::vector<float> m_history;
+};
+
+#endif // UI_ANALOG_HPP
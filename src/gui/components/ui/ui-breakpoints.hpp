@@ -0,0 +1,114 @@
+#ifndef UI_BREAKPOINTS_HPP
+#define UI_BREAKPOINTS_HPP
+
+#include <imgui.h>
+#include <string>
+
+#include "../irenderable.hpp"
+#include "../../controller.hpp"
+
+class UiBreakpoints : public IRenderable {
+public:
+    UiBreakpoints(Controller& controller) : m_controller(controller) {}
+
+    void render() override {
+        renderAdd();
+
+        ImGui::Separator();
+
+        const MachineSnapshot& snapshot = m_controller.snapshot();
+
+        if (!ImGui::BeginTable("Breakpoints", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+            return;
+
+        ImGui::TableSetupColumn("On");
+        ImGui::TableSetupColumn("ADR");
+        ImGui::TableSetupColumn("Condition");
+        ImGui::TableSetupColumn("Hits");
+        ImGui::TableSetupColumn("Action");
+        ImGui::TableSetupColumn("");
+        ImGui::TableHeadersRow();
+
+        ImGuiStyle& style = ImGui::GetStyle();
+
+        for (int i = 0; i < snapshot.breakpointCount; i++) {
+            const Breakpoint& breakpoint = snapshot.breakpoints[i];
+            auto color = (breakpoint.id == snapshot.breakpointStoppedBy)
+                         ? style.Colors[ImGuiCol_ButtonHovered]
+                         : style.Colors[ImGuiCol_Text];
+            std::string id = std::to_string(breakpoint.id);
+
+            ImGui::TableNextRow();
+
+            ImGui::TableSetColumnIndex(0);
+            bool enabled = breakpoint.enabled;
+            if (ImGui::Checkbox(("##on" + id).c_str(), &enabled)) {
+                m_controller.setBreakpointEnabled(breakpoint.id, enabled);
+            }
+
+            ImGui::TableSetColumnIndex(1);
+            ImGui::TextColored(color, "%04X", breakpoint.address);
+
+            ImGui::TableSetColumnIndex(2);
+            ImGui::TextColored(color, "%s", breakpoint.condition.empty() ? "-" : breakpoint.condition.text());
+
+            ImGui::TableSetColumnIndex(3);
+            ImGui::TextColored(color, "%u / %u", (unsigned)breakpoint.hits,
+                               (unsigned)breakpoint.hitThreshold);
+
+            ImGui::TableSetColumnIndex(4);
+            ImGui::TextColored(color, "%s", breakpoint.logOnly ? "Log" : "Stop");
+
+            ImGui::TableSetColumnIndex(5);
+            if (ImGui::SmallButton(("Delete##" + id).c_str())) {
+                m_controller.removeBreakpoint(breakpoint.id);
+            }
+        }
+
+        ImGui::EndTable();
+
+        if (ImGui::Button("Reset hits")) m_controller.resetBreakpointHits();
+    }
+
+private:
+    Controller& m_controller;
+
+    uint16_t m_address = 0x0800;
+    char m_condition[EXPRESSION_TEXT_SIZE] = "";
+    int m_hits = 1;
+    bool m_logOnly = false;
+    bool m_badCondition = false;
+
+    void renderAdd() {
+        ImGui::PushItemWidth(60);
+        ImGui::InputScalar("ADR", ImGuiDataType_U16, &m_address, NULL, NULL, "%04X");
+        ImGui::PopItemWidth();
+
+        ImGui::SameLine();
+        ImGui::PushItemWidth(220);
+        ImGui::InputTextWithHint("Condition", "A == 3F && [0BF0] != 0", m_condition,
+                                 sizeof(m_condition));
+        ImGui::PopItemWidth();
+
+        ImGui::SameLine();
+        ImGui::PushItemWidth(80);
+        if (ImGui::InputInt("Hits", &m_hits) && m_hits < 1) m_hits = 1;
+        ImGui::PopItemWidth();
+
+        ImGui::SameLine();
+        ImGui::Checkbox("Log only", &m_logOnly);
+
+        ImGui::SameLine();
+        if (ImGui::Button("Add")) {
+            m_badCondition =
+                !m_controller.addBreakpoint(m_address, m_condition, (uint32_t)m_hits, m_logOnly);
+        }
+
+        if (m_badCondition) {
+            ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f),
+                               "Bad condition or too many breakpoints");
+        }
+    }
+};
+
+#endif // UI_BREAKPOINTS_HPP
@@ -45,8 +45,11 @@ private:
     uint8_t m_registers[8] = { 0 };
     bool m_flags[5] = { 0 };
 
-    const char* m_controlButtons[4] = {
-        "Start", "Step", "Stop", "Reset"
+    // Multiplier restored when Unlimited is unchecked
+    float m_speed = 1.0f;
+
+    const char* m_controlButtons[6] = {
+        "Start", "Step", "Step over", "Step out", "Stop", "Reset"
     };
 
     void renderControls() {
@@ -55,8 +58,10 @@ private:
                 switch (i) {
                     case 0: m_controller.onBtnStart(); break;
                     case 1: m_controller.onBtnNextCommand(); break;
-                    case 2: m_controller.onButtonStop(); break;
-                    case 3: m_controller.onBtnReset(); break;
+                    case 2: m_controller.onBtnStepOver(); break;
+                    case 3: m_controller.onBtnStepOut(); break;
+                    case 4: m_controller.onButtonStop(); break;
+                    case 5: m_controller.onBtnReset(); break;
                 }
             }
 
@@ -65,11 +70,59 @@ private:
 
         ImGui::NewLine();
 
+        auto& snapshot = m_controller.snapshot();
+        ImGui::Text("Slice: %u cycles, %u us, %llu of %llu overran",
+                    snapshot.sliceCycles, snapshot.sliceMicros,
+                    (unsigned long long)snapshot.sliceOverruns,
+                    (unsigned long long)snapshot.slices);
+
+        renderSpeed(snapshot);
+        renderHle();
+
         ImGui::Spacing();
         ImGui::Separator();
         ImGui::Spacing();
     }
 
+    void renderSpeed(const MachineSnapshot& snapshot) {
+        bool unlimited = snapshot.speed <= 0;
+
+        if (ImGui::Checkbox("Unlimited", &unlimited)) {
+            m_controller.setSpeed(unlimited ? 0 : m_speed);
+        }
+
+        if (!unlimited) {
+            m_speed = (float)snapshot.speed;
+
+            ImGui::SameLine();
+            ImGui::PushItemWidth(120);
+            if (ImGui::InputFloat("Speed", &m_speed, 0.5f, 1.0f, "%.2fx") && m_speed > 0) {
+                m_controller.setSpeed(m_speed);
+            }
+            ImGui::PopItemWidth();
+        }
+
+        ImGui::SameLine();
+        ImGui::Text("%.3f MHz, jitter %u us (max %u us)", snapshot.achievedHz / 1e6,
+                    snapshot.jitterMeanMicros, snapshot.jitterMaxMicros);
+    }
+
+    void renderHle() {
+        ImGui::TextUnformatted("HLE:");
+
+        for (int i = 0; i < (int)HleRoutine::Count; i++) {
+            const HleRoutineInfo& info = hleRoutineInfo((HleRoutine)i);
+            bool enabled = m_controller.isHle((HleRoutine)i);
+
+            ImGui::SameLine();
+            if (ImGui::Checkbox(info.name, &enabled)) {
+                m_controller.setHle((HleRoutine)i, enabled);
+            }
+
+            if (ImGui::IsItemHovered()) ImGui::SetTooltip("%04Xh", info.address);
+        }
+    }
+
     void renderRegisters() {
         if (!ImGui::BeginTable("Registers", 8, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
             return;
@@ -85,8 +138,6 @@ private:
 
         ImGui::TableNextRow();
 
-        auto& cpu = m_controller.umpk().getCpu();
-
         for (int i = 0; i < 8; i++)
             m_registers[i] = m_controller.getRegister((Cpu::Register)i);
 
@@ -127,8 +178,7 @@ private:
 
         ImGui::TableNextRow();
 
-        auto& cpu = m_controller.umpk().getCpu();
-        auto flags = cpu.getFlags();
+        auto flags = m_controller.snapshot().flags;
 
         // TODO Refactor me 
         m_flags[0] = flags.carry;
@@ -153,7 +203,7 @@ private:
                     flags.auxcarry = m_flags[3];
                     flags.parity = m_flags[4];
 
-                    cpu.setFlags(flags);
+                    m_controller.setCpuFlags(flags);
                 }
             }      
         }
@@ -172,9 +222,9 @@ private:
 
         ImGui::TableNextRow();
 
-        auto& cpu = m_controller.umpk().getCpu();
+        auto& snapshot = m_controller.snapshot();
 
-        m_programCounter = cpu.getProgramCounter();
+        m_programCounter = snapshot.programCounter;
 
         ImGui::TableSetColumnIndex(0);
         if (m_controller.isUmpkRunning()) {
@@ -191,7 +241,7 @@ private:
             }
         }
 
-        m_stackPointer = cpu.getStackPointer();
+        m_stackPointer = snapshot.stackPointer;
 
         ImGui::TableSetColumnIndex(1);
         if (m_controller.isUmpkRunning()) {
@@ -209,8 +259,8 @@ private:
         }
         ImGui::TableSetColumnIndex(2);
         std::string mnemonic =
-            Disassembler::getInstruction(cpu.getCommandRegister()).mnemonic;
-        ImGui::Text("%02X | %s", cpu.getCommandRegister(), mnemonic.c_str());
+            Disassembler::getInstruction(snapshot.commandRegister).mnemonic;
+        ImGui::Text("%02X | %s", snapshot.commandRegister, mnemonic.c_str());
         
         ImGui::EndTable();
     }
@@ -15,7 +15,7 @@ public:
     UiIoRegister(Controller &controller) : m_controller(controller) {}
 
     void render() override {
-        ImGui::Text("P%02X Out", m_controller.umpk().PORT_IO);
+        ImGui::Text("P%02X Out", m_controller.snapshot().ioPort);
 
         for (uint8_t i = 0x80, c = 7; i != 0; i >>= 1, c--) {
             ImGui::RadioButton(("##o" + std::to_string(c)).c_str(),
@@ -29,7 +29,7 @@ public:
         ImGui::NewLine();
         ImGui::Separator();
 
-        ImGui::Text("P%02x In", m_controller.umpk().PORT_IO);
+        ImGui::Text("P%02x In", m_controller.snapshot().ioPort);
 
         uint8_t inData = vecToUint8(vecIn);
         for (int i = 0; i < 8; i++) {
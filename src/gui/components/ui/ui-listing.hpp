@@ -21,11 +21,11 @@ struct UiListingLine {
 
 class UiListing : public IRenderable {
 public:
-    UiListing(std::vector<UiListingLine>& listing, bool enableScroll = false, int* cursorPos = nullptr, int* breakpoint = nullptr ) 
+    UiListing(std::vector<UiListingLine>& listing, bool enableScroll = false, int* cursorPos = nullptr, Controller* breakpoints = nullptr) 
         : m_listing(listing)
         , m_enableScroll(enableScroll)
         , m_cursorPos(cursorPos)
-        , m_breakPoint(breakpoint)
+        , m_breakpoints(breakpoints)
     {}
 
     void render() override {
@@ -50,7 +50,7 @@ private:
     std::vector<UiListingLine>& m_listing;
     bool m_enableScroll;
     int* m_cursorPos;
-    int* m_breakPoint;
+    Controller* m_breakpoints;
 
     char m_exportFileNameBuffer[255] = "disassembled.txt";
     int prevCursorPos = -1;
@@ -85,16 +85,30 @@ private:
                     ImColor(ImGui::GetStyle().Colors[ImGuiCol_TableHeaderBg]),
                     0);
 
-                if (m_breakPoint != nullptr) {
+                if (m_breakpoints != nullptr) {
+                    const Breakpoint* breakpoint = m_breakpoints->breakpointAt(listingRow.address);
+
                     ImGui::TableSetColumnIndex(0);
-                    if (ImGui::Selectable(("##rb" + std::to_string(row)).c_str(), *m_breakPoint == row)) {
-                        *m_breakPoint = (*m_breakPoint != row) ? row : -1;
+                    if (ImGui::Selectable(("##rb" + std::to_string(row)).c_str(), breakpoint != nullptr)) {
+                        m_breakpoints->toggleBreakpoint(listingRow.address);
+                    }
+
+                    if (breakpoint != nullptr && ImGui::IsItemHovered()) {
+                        ImGui::SetTooltip("#%d %s, %u hits", breakpoint->id,
+                                          breakpoint->condition.empty() ? "always" : breakpoint->condition.text(),
+                                          (unsigned)breakpoint->hits);
                     }
                 }
 
                 ImGui::TableSetColumnIndex(1);
                 ImGui::TextColored(color, "%04X", listingRow.address);
 
+                if (m_breakpoints != nullptr &&
+                    ImGui::BeginPopupContextItem(("##rt" + std::to_string(row)).c_str())) {
+                    if (ImGui::MenuItem("Run to here")) m_breakpoints->runTo(listingRow.address);
+                    ImGui::EndPopup();
+                }
+
                 ImGui::TableSetColumnIndex(2);
                 ImGui::TextColored(color, "%02X", listingRow.byte);
 
@@ -129,8 +143,8 @@ private:
 
 class UiMemoryDisassembler : public IRenderable {
 public:
-    UiMemoryDisassembler(int* cursor = nullptr, int* breakpoint = nullptr) 
-        : m_uiListing(m_listing, true, cursor, breakpoint)
+    UiMemoryDisassembler(int* cursor = nullptr, Controller* breakpoints = nullptr) 
+        : m_uiListing(m_listing, true, cursor, breakpoints)
     {}
 
     void render() override {
@@ -165,14 +179,14 @@ class UiOsListing : public IRenderable {
 public:
     UiOsListing(Controller &controller)
         : m_controller(controller)
-        , m_uiDisassembler(&m_cursorpos, &m_controller.breakpoint)
+        , m_uiDisassembler(&m_cursorpos, &m_controller)
     {
         m_uiDisassembler.disassemble(m_controller.getRom(), 0x1000);
     }
 
     void render() override {
         m_uiDisassembler.disassemble(m_controller.getRom(), 0x1000);
-        m_cursorpos = m_controller.umpk().getCpu().getProgramCounter();
+        m_cursorpos = m_controller.snapshot().programCounter;
         m_uiDisassembler.render();
     }
 
@@ -202,7 +216,7 @@ public:
             ImGuiStyle &style = ImGui::GetStyle();
 
             const uint8_t* rom = m_controller.getRom();
-            int stackPointer = m_controller.umpk().getCpu().getStackPointer();
+            int stackPointer = m_controller.snapshot().stackPointer;
 
             constexpr uint16_t stackHigh = 0x0BD0;
             constexpr uint16_t stackLow  = 0x0B00;
@@ -239,7 +253,7 @@ public:
 
         ImGui::Text("Stack Pointer:");
         ImGui::SameLine();
-        ImGui::TextColored(ImVec4(1.0f, 1.0f, 0.0f, 1.0f), "%04X", m_controller.umpk().getCpu().getStackPointer());
+        ImGui::TextColored(ImVec4(1.0f, 1.0f, 0.0f, 1.0f), "%04X", m_controller.snapshot().stackPointer);
 
         ImGui::Spacing();
     }
@@ -0,0 +1,69 @@
+#ifndef UI_PRINTER_HPP
+#define UI_PRINTER_HPP
+
+#include <imgui.h>
+#include <string>
+#include <vector>
+
+#include "../irenderable.hpp"
+#include "../../controller.hpp"
+
+class UiPrinter : public IRenderable {
+public:
+    UiPrinter(Controller& controller) : m_controller(controller) {}
+
+    void render() override {
+        PrinterCapture* printer = m_controller.printer();
+
+        if (printer == nullptr) {
+            ImGui::TextUnformatted("Printer is not connected (--printer <hex port>)");
+            return;
+        }
+
+        int pages = (int)printer->pageCount();
+
+        ImGui::Text("Printed %llu bytes", (unsigned long long)printer->bytes());
+        if (!printer->fileName().empty()) {
+            ImGui::SameLine();
+            ImGui::Text("to %s", printer->fileName().c_str());
+        }
+
+        ImGui::Checkbox("Follow", &m_follow);
+        ImGui::SameLine();
+
+        if (m_follow) m_page = pages;
+
+        ImGui::PushItemWidth(100);
+        if (ImGui::InputInt("Page", &m_page)) m_follow = false;
+        ImGui::PopItemWidth();
+
+        if (m_page < 1) m_page = 1;
+        if (m_page > pages) m_page = pages;
+
+        ImGui::SameLine();
+        ImGui::Text("of %d", pages);
+
+        ImGui::Separator();
+        ImGui::BeginChild("##paper");
+
+        if (printer->getPage(m_page - 1, m_lines)) {
+            for (auto& line : m_lines) ImGui::TextUnformatted(line.c_str());
+
+            if (m_follow) ImGui::SetScrollHereY(1.0f);
+        } else {
+            ImGui::TextUnformatted("The page was discarded, it is only in the output file");
+        }
+
+        ImGui::EndChild();
+    }
+
+private:
+    Controller& m_controller;
+
+    // Shown page, from 1
+    int m_page = 1;
+    bool m_follow = true;
+    std::vector<std::string> m_lines;
+};
+
+#endif // UI_PRINTER_HPP
@@ -0,0 +1,79 @@
+#ifndef UI_WATCH_HPP
+#define UI_WATCH_HPP
+
+#include <imgui.h>
+#include <string>
+#include <vector>
+
+#include "../irenderable.hpp"
+#include "../../controller.hpp"
+
+// Expressions evaluated on every frame's snapshot
+class UiWatch : public IRenderable {
+public:
+    UiWatch(Controller& controller) : m_controller(controller) {}
+
+    void render() override {
+        ImGui::PushItemWidth(260);
+        bool entered = ImGui::InputTextWithHint("##watch", "W[0BF0] + CY", m_text, sizeof(m_text),
+                                                ImGuiInputTextFlags_EnterReturnsTrue);
+        ImGui::PopItemWidth();
+
+        ImGui::SameLine();
+        if (ImGui::Button("Watch") || entered) {
+            Expression expression;
+
+            m_badExpression = !expression.compile(m_text);
+
+            if (!m_badExpression) {
+                m_watches.push_back(expression);
+                m_text[0] = 0;
+            }
+        }
+
+        if (m_badExpression) {
+            ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "Bad expression");
+        }
+
+        ImGui::Separator();
+
+        if (!ImGui::BeginTable("Watch", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+            return;
+
+        ImGui::TableSetupColumn("Expression");
+        ImGui::TableSetupColumn("Value");
+        ImGui::TableSetupColumn("");
+        ImGui::TableHeadersRow();
+
+        SnapshotView view(m_controller.snapshot());
+
+        for (size_t i = 0; i < m_watches.size(); i++) {
+            unsigned long long value = m_watches[i].evaluate(view);
+
+            ImGui::TableNextRow();
+
+            ImGui::TableSetColumnIndex(0);
+            ImGui::TextUnformatted(m_watches[i].text());
+
+            ImGui::TableSetColumnIndex(1);
+            ImGui::Text("%llXh (%llu)", value, value);
+
+            ImGui::TableSetColumnIndex(2);
+            if (ImGui::SmallButton(("Delete##" + std::to_string(i)).c_str())) {
+                m_watches.erase(m_watches.begin() + i);
+                break;
+            }
+        }
+
+        ImGui::EndTable();
+    }
+
+private:
+    Controller& m_controller;
+
+    std::vector<Expression> m_watches;
+    char m_text[EXPRESSION_TEXT_SIZE] = "";
+    bool m_badExpression = false;
+};
+
+#endif // UI_WATCH_HPP
@@ -1,5 +1,8 @@
 #include "controller.hpp"
 #include "disassemble-result-to-string.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <iomanip>
 
@@ -41,63 +44,362 @@ void Controller::decompileToFile(std::string filename, uint16_t fromAdr,
 }
 
 void Controller::onBtnStart() {
+    _changeRunState(RunState::Stopped, RunState::Running);
+}
+
+void Controller::onButtonStop() {
+    if (!_changeRunState(RunState::Running, RunState::Stopped) &&
+        _changeRunState(RunState::RunningTo, RunState::Stopped)) {
+        // The slice ends on the state change, the target isn't needed
+        // any longer
+        _umpkMutex.lock();
+        _clearRunTo();
+        _umpkMutex.unlock();
+    }
+
+    _ramImage.flush();
+}
+
+void Controller::onBtnNextCommand() {
+    _changeRunState(RunState::Stopped, RunState::Stepping);
+}
+
+void Controller::onBtnStepOver() {
+    ControllerCommand command;
+    command.type = ControllerCommand::Type::StepOver;
+
+    _sendCommand(std::move(command));
+}
+
+void Controller::onBtnStepOut() {
+    ControllerCommand command;
+    command.type = ControllerCommand::Type::StepOut;
+
+    _sendCommand(std::move(command));
+}
+
+void Controller::runTo(uint16_t address) {
+    ControllerCommand command;
+    command.type = ControllerCommand::Type::RunTo;
+    command.address = address;
+
+    _sendCommand(std::move(command));
+}
+
+void Controller::onBtnReset() {
+    ControllerCommand command;
+    command.type = ControllerCommand::Type::Restart;
+
+    _sendCommand(std::move(command));
+}
+
+void Controller::setUmpkKey(KeyboardKey key, bool value) {
+    // Called every frame for every key, only changes are queued.
+    // The emulation thread applies them, so no lock is taken here.
+    if (_guiKeys[(int)key] == value) return;
+
+    if (_umpk.queueKey(key, value)) _guiKeys[(int)key] = value;
+}
+
+void Controller::port5In(uint8_t data) {
+    ControllerCommand command;
+    command.type = ControllerCommand::Type::SetPort5In;
+    command.value = data;
+
+    _sendCommand(std::move(command));
+}
+
+void Controller::setCpuFlags(CpuFlagsMapping flags) {
+    ControllerCommand command;
+    command.type = ControllerCommand::Type::SetFlags;
+    command.flags = flags;
+
+    _sendCommand(std::move(command));
+}
+
+void Controller::setCpuProgramCounter(uint16_t value) {
+    ControllerCommand command;
+    command.type = ControllerCommand::Type::SetProgramCounter;
+    command.address = value;
+
+    _sendCommand(std::move(command));
+}
+
+void Controller::setCpuStackPointer(uint16_t sp) {
+    ControllerCommand command;
+    command.type = ControllerCommand::Type::SetStackPointer;
+    command.address = sp;
+
+    _sendCommand(std::move(command));
+}
+
+void Controller::setMemory(uint16_t index, uint8_t data) {
+    ControllerCommand command;
+    command.type = ControllerCommand::Type::WriteMemory;
+    command.address = index;
+    command.data.assign(1, data);
+
+    _sendCommand(std::move(command));
+}
+
+void Controller::setDisplayFastPath(bool enabled) {
+    setHle(HleRoutine::DisplayScan, enabled);
+}
+
+void Controller::setHle(HleRoutine routine, bool enabled) {
     _umpkMutex.lock();
-    _isUmpkFreezed = false;
+    _umpk.setHle(routine, enabled);
     _umpkMutex.unlock();
+
+    _refreshSnapshot();
 }
 
-void Controller::onButtonStop() {
+void Controller::setFrameRate(uint32_t hz) {
+    if (hz == 0) hz = 1;
+    if (hz > FRAME_RATE_MAX) hz = FRAME_RATE_MAX;
+
     _umpkMutex.lock();
-    _isUmpkFreezed = true;
+    _sliceCycles = UMPK80_CLOCK_HZ / hz;
+    _slicePeriodMicros = 1000000 / hz;
     _umpkMutex.unlock();
 }
 
-void Controller::onBtnNextCommand() {
+void Controller::setSpeed(double multiplier) {
     _umpkMutex.lock();
-    _umpk.tick();
+    _speed = (multiplier > 0) ? multiplier : 0;
     _umpkMutex.unlock();
 }
 
-void Controller::onBtnReset() {
+void Controller::setupModules(const EmulatorOptions& options) {
     _umpkMutex.lock();
-    _umpk.restart();
+    connectExpansionModules(_umpk, options);
     _umpkMutex.unlock();
 }
 
-void Controller::setUmpkKey(KeyboardKey key, bool value) {
+void Controller::setupSerial(const EmulatorOptions& options) {
+    std::unique_ptr<SerialStream> stream;
+
+    if (options.serialPort >= 0) {
+        try {
+            stream.reset(new SerialStream(options.serialIn, options.serialOut, options.serialPty));
+        } catch (const std::exception& e) {
+            std::cout << "[ERR] " << e.what() << ". Serial line is not connected.\n";
+        }
+
+        if (stream && options.serialPty) {
+            std::cout << "[INFO] Serial line is on " << stream->ptyName() << "\n";
+        }
+    }
+
     _umpkMutex.lock();
-    (value == true) ? _umpk.pressKey(key) : _umpk.releaseKey(key);
+    _umpk.getUsart().setHost(stream.get());
+    _umpk.getUsart().setBaudRate(options.serialBaud);
+    _umpk.getUsart().setInterrupt(options.serialRst);
+    bool mapped = _umpk.setUsartPort(options.serialPort);
+    _serialStream.swap(stream);
     _umpkMutex.unlock();
+
+    warnPortsTaken(mapped, "serial line", options.serialPort);
 }
 
-void Controller::port5In(uint8_t data) {
+void Controller::setupPrinter(const EmulatorOptions& options) {
     _umpkMutex.lock();
-    _umpk.port5InSet(data);
+    _umpk.setPrinterPort(-1);
     _umpkMutex.unlock();
+
+    // The old capture drains the printer until it's gone
+    _printerCapture.reset();
+
+    if (options.printerPort < 0) return;
+
+    try {
+        _printerCapture.reset(new PrinterCapture(_umpk.getPrinter(), options.printerOut,
+                                                 options.printerPageLines));
+    } catch (const std::exception& e) {
+        std::cout << "[ERR] " << e.what() << ". Printer is not connected.\n";
+        return;
+    }
+
+    _umpkMutex.lock();
+    bool mapped = _umpk.setPrinterPort(options.printerPort);
+    _umpkMutex.unlock();
+
+    warnPortsTaken(mapped, "printer", options.printerPort);
 }
 
-void Controller::setCpuFlags(CpuFlagsMapping flags) {
+void Controller::setupAnalog(const EmulatorOptions& options) {
+    std::unique_ptr<AnalogSource> source;
+
+    if (options.adcPort >= 0) {
+        try {
+            source.reset(createAnalogSource(options.adcIn, options.adcRate,
+                                            options.adcWave, UMPK80_CLOCK_HZ));
+        } catch (const std::exception& e) {
+            std::cout << "[ERR] " << e.what() << ". ADC input is not connected.\n";
+        }
+    }
+
+    _umpkMutex.lock();
+    _umpk.setDacPort(-1);
+    _umpk.getAdc().setSource(source.get());
+    bool mapped = _umpk.setAdcPort(options.adcPort);
+    _adcSource.swap(source);
+    _umpkMutex.unlock();
+
+    warnPortsTaken(mapped, "ADC", options.adcPort);
+
+    _refreshSnapshot();
+
+    // The old recorder drains the DAC until it's gone
+    _dacRecorder.reset();
+
+    if (options.dacPort < 0) return;
+
+    try {
+        _dacRecorder.reset(new DacRecorder(_umpk.getDac(), options.dacOut));
+    } catch (const std::exception& e) {
+        std::cout << "[ERR] " << e.what() << ". DAC is not connected.\n";
+        return;
+    }
+
     _umpkMutex.lock();
-    _umpk.getCpu().setFlags(flags);
+    mapped = _umpk.setDacPort(options.dacPort);
     _umpkMutex.unlock();
+
+    warnPortsTaken(mapped, "DAC", options.dacPort);
+
+    _refreshSnapshot();
 }
 
-void Controller::setCpuProgramCounter(uint16_t value) {
+void Controller::setSoundSource(SoundSource source) {
     _umpkMutex.lock();
-    _umpk.getCpu().setProgramCounter(value);
+    _soundSource = source;
+
+    if (source == SoundSource::Speaker) {
+        if (!_speakerStream) {
+            _speakerStream.reset(new SpeakerStream(UMPK80_CLOCK_HZ));
+            _speakerStream->play();
+        }
+        _umpk.setSpeakerListener(_speakerStream.get());
+    } else {
+        _umpk.setSpeakerListener(nullptr);
+    }
     _umpkMutex.unlock();
 }
 
-void Controller::setCpuStackPointer(uint16_t sp) {
+void Controller::attachRamImage(const std::string& path) {
     _umpkMutex.lock();
-    _umpk.getCpu().setStackPointer(sp);
+    try {
+        _umpk.getBus().memoryAttach(nullptr);
+        _ramImage.open(path, MEMORY_SIZE);
+    } catch (...) {
+        _umpkMutex.unlock();
+        throw;
+    }
+    _umpk.getBus().memoryAttach(_ramImage.data());
     _umpkMutex.unlock();
+
+    // The image brings its own RAM contents
+    _refreshSnapshot();
 }
 
-void Controller::setMemory(uint16_t index, uint8_t data) {
+void Controller::setupBreakpoints(const EmulatorOptions& options) {
     _umpkMutex.lock();
-    _umpk.getBus().memoryWrite(index, data);
+    _umpk.getBreakpoints().setListener(this);
     _umpkMutex.unlock();
+
+    for (const BreakpointOption& option : options.breakpoints) {
+        if (!addBreakpoint(option.address, option.condition, option.hits, option.logOnly)) {
+            std::cout << "[WARN] Breakpoint at " << std::hex << std::uppercase << option.address
+                      << std::dec << std::nouppercase << "h is not set, bad condition \"" << option.condition
+                      << "\" or too many breakpoints.\n";
+        }
+    }
+}
+
+bool Controller::addBreakpoint(uint16_t address, const std::string& condition,
+                               uint32_t hitThreshold, bool logOnly) {
+    Expression expression;
+
+    if (!expression.compile(condition.c_str())) return false;
+    if (snapshot().breakpointCount == BREAKPOINTS_MAX) return false;
+
+    ControllerCommand command;
+    command.type = ControllerCommand::Type::AddBreakpoint;
+    command.address = address;
+    command.text = condition;
+    command.count = hitThreshold;
+    command.flag = logOnly;
+    _sendCommand(std::move(command));
+
+    return true;
+}
+
+void Controller::removeBreakpoint(int id) {
+    ControllerCommand command;
+    command.type = ControllerCommand::Type::RemoveBreakpoint;
+    command.id = id;
+    _sendCommand(std::move(command));
+}
+
+void Controller::setBreakpointEnabled(int id, bool enabled) {
+    ControllerCommand command;
+    command.type = ControllerCommand::Type::SetBreakpointEnabled;
+    command.id = id;
+    command.flag = enabled;
+    _sendCommand(std::move(command));
+}
+
+void Controller::resetBreakpointHits() {
+    ControllerCommand command;
+    command.type = ControllerCommand::Type::ResetBreakpointHits;
+    _sendCommand(std::move(command));
+}
+
+void Controller::toggleBreakpoint(uint16_t address) {
+    ControllerCommand command;
+    command.type = ControllerCommand::Type::ToggleBreakpoint;
+    command.address = address;
+    _sendCommand(std::move(command));
+}
+
+const Breakpoint* Controller::breakpointAt(uint16_t address) const {
+    const MachineSnapshot& current = snapshot();
+    int low = 0, high = current.breakpointCount;
+
+    // Kept in address order
+    while (low < high) {
+        int middle = (low + high) / 2;
+
+        if (current.breakpoints[middle].address < address) low = middle + 1;
+        else high = middle;
+    }
+
+    if (low < current.breakpointCount && current.breakpoints[low].address == address) {
+        return &current.breakpoints[low];
+    }
+
+    return nullptr;
+}
+
+bool Controller::_startRunTo() {
+    // Start pressed since the target was taken
+    if (_changeRunState(RunState::Stopped, RunState::RunningTo)) return true;
+
+    _clearRunTo();
+    return false;
+}
+
+void Controller::_clearRunTo() {
+    _umpk.getBreakpoints().clearTemporary();
+    _steppingOut = false;
+}
+
+void Controller::_refreshSnapshot() {
+    ControllerCommand command;
+    command.type = ControllerCommand::Type::Refresh;
+
+    _sendCommand(std::move(command));
 }
 
 std::vector<uint8_t> Controller::readBinaryFile(std::string path) {
@@ -121,11 +423,12 @@ std::vector<uint8_t> Controller::readBinaryFile(std::string path) {
 
 void Controller::loadProgramToMemory(uint16_t position,
                                      std::vector<uint8_t> &program) {
-    _umpkMutex.lock();
-    for (size_t i = 0; i < program.size(); i++) {
-        _umpk.getBus().memoryWrite(position + i, program[i]);
-    }
-    _umpkMutex.unlock();
+    ControllerCommand command;
+    command.type = ControllerCommand::Type::WriteMemory;
+    command.address = position;
+    command.data = program;
+
+    _sendCommand(std::move(command));
 }
 
 void Controller::_loadSystem() {
@@ -139,51 +442,481 @@ void Controller::_loadSystem() {
     _umpk.loadOS((const uint8_t *)os);
 }
 
+static const uint16_t SOUND_FUNC_ADR = 0x0447;
+static const uint16_t START_END_ADR  = 0x00C5;
+
+void Controller::_markHooks() {
+    _umpkMutex.lock();
+    _umpk.markAddress(SOUND_FUNC_ADR);
+    _umpk.markAddress(START_END_ADR);
+    _umpkMutex.unlock();
+}
+
 void Controller::_handleHooks(Cpu &cpu) {
     uint16_t pgCounter = cpu.getProgramCounter();
 
-    const uint16_t SOUND_FUNC_ADR = 0x0447;
-    const uint16_t DELAY_FUNC_ADR = 0x0506;
-    const uint16_t START_END_ADR  = 0x00C5;
-
     if (pgCounter == START_END_ADR) {
         _gui.onUmpkOsStartupFinished();
     }
 
-    if (pgCounter == SOUND_FUNC_ADR) {
+    if (pgCounter == SOUND_FUNC_ADR && _soundSource == SoundSource::Hook) {
         uint8_t duration = cpu.getRegister(Cpu::Register::D);
         uint8_t frequency = 0xFF - cpu.getRegister(Cpu::Register::B);
 
+        // Only queues the note, the subroutine itself keeps running
+        // so emulated time advances by exactly the tone's length
         dj.tone(frequency * 2, duration * 130);
     }
+}
+
+std::string Controller::breakpointHitToString(const Breakpoint& breakpoint, Cpu& cpu) {
+    char line[128];
+
+    snprintf(line, sizeof(line),
+             "Breakpoint %d at %04Xh, hit %u: A=%02X BC=%02X%02X DE=%02X%02X HL=%02X%02X SP=%04X",
+             breakpoint.id, breakpoint.address, (unsigned)breakpoint.hits, cpu.A(), cpu.B(), cpu.C(),
+             cpu.D(), cpu.E(), cpu.H(), cpu.L(), cpu.getStackPointer());
+
+    return line;
+}
+
+void Controller::breakpointLogged(const Breakpoint& breakpoint) {
+    std::cout << "[INFO] " << breakpointHitToString(breakpoint, _umpk.getCpu()) << ".\n";
+}
+
+void Controller::_setRunState(RunState state) {
+    {
+        std::lock_guard<std::mutex> lock(_stateMutex);
+
+        if (_runState.load(std::memory_order_relaxed) == RunState::ShuttingDown) return;
+
+        _runState.store(state, std::memory_order_release);
+    }
+
+    _stateChanged.notify_all();
+}
+
+bool Controller::_changeRunState(RunState from, RunState to) {
+    {
+        std::lock_guard<std::mutex> lock(_stateMutex);
+
+        if (_runState.load(std::memory_order_relaxed) != from) return false;
+
+        _runState.store(to, std::memory_order_release);
+    }
+
+    _stateChanged.notify_all();
+    return true;
+}
+
+void Controller::_sendCommand(ControllerCommand&& command) {
+    if (std::this_thread::get_id() == _umpkThread.get_id()) {
+        _applyCommand(command);
+        return;
+    }
+
+    // The emulation thread drains the queue before every slice
+    while (!_commands.push(std::move(command))) std::this_thread::yield();
+
+    // A stopped emulation thread sleeps, wake it up to apply the command.
+    // Taking the state mutex orders the push before its check.
+    { std::lock_guard<std::mutex> lock(_stateMutex); }
+    _stateChanged.notify_all();
+}
+
+bool Controller::_applyCommands() {
+    ControllerCommand command;
+    bool applied = false;
+
+    while (_commands.pop(command)) {
+        _applyCommand(command);
+        applied = true;
+    }
+
+    return applied;
+}
+
+void Controller::_applyCommand(ControllerCommand& command) {
+    Cpu& cpu = _umpk.getCpu();
+
+    switch (command.type) {
+    case ControllerCommand::Type::WriteMemory:
+        for (size_t i = 0; i < command.data.size(); i++) {
+            _umpk.getBus().memoryWrite(command.address + i, command.data[i]);
+        }
+        break;
+
+    case ControllerCommand::Type::SetRegister:
+        cpu.setRegister(command.reg, command.value);
+        break;
+
+    case ControllerCommand::Type::SetFlags:
+        cpu.setFlags(command.flags);
+        break;
+
+    case ControllerCommand::Type::SetProgramCounter:
+        cpu.setProgramCounter(command.address);
+        break;
+
+    case ControllerCommand::Type::SetStackPointer:
+        cpu.setStackPointer(command.address);
+        break;
+
+    case ControllerCommand::Type::SetPort5In:
+        _umpk.port5InSet(command.value);
+        break;
+
+    case ControllerCommand::Type::Restart:
+        _umpk.restart();
+        break;
+
+    case ControllerCommand::Type::Refresh:
+        break;
+
+    case ControllerCommand::Type::StepOver:
+        _stepOver();
+        break;
+
+    case ControllerCommand::Type::StepOut:
+        _stepOut();
+        break;
+
+    case ControllerCommand::Type::RunTo:
+        _runTo(command.address);
+        break;
+
+    case ControllerCommand::Type::AddBreakpoint:
+        _addBreakpoint(command);
+        break;
+
+    case ControllerCommand::Type::RemoveBreakpoint:
+        _umpk.getBreakpoints().remove(command.id);
+        break;
+
+    case ControllerCommand::Type::SetBreakpointEnabled:
+        _umpk.getBreakpoints().setEnabled(command.id, command.flag);
+        break;
+
+    case ControllerCommand::Type::ResetBreakpointHits:
+        _umpk.getBreakpoints().resetHits();
+        break;
+
+    case ControllerCommand::Type::ToggleBreakpoint:
+        _toggleBreakpoint(command.address);
+        break;
+    }
+}
+
+void Controller::_addBreakpoint(const ControllerCommand& command) {
+    int id = _umpk.getBreakpoints().add(command.address, command.text.c_str(),
+                                        command.count, command.flag);
+
+    // The condition was checked when queued, the table may have filled since
+    if (id == 0) {
+        std::cout << "[WARN] Breakpoint at " << std::hex << std::uppercase << command.address
+                  << std::dec << std::nouppercase << "h is not set, too many breakpoints.\n";
+    }
+}
+
+void Controller::_toggleBreakpoint(uint16_t address) {
+    Breakpoints& breakpoints = _umpk.getBreakpoints();
+    bool removed = false;
+
+    for (int i = breakpoints.count() - 1; i >= 0; i--) {
+        if (breakpoints.at(i).address != address) continue;
+
+        breakpoints.remove(breakpoints.at(i).id);
+        removed = true;
+    }
+
+    if (!removed) breakpoints.add(address);
+}
+
+void Controller::_stepOver() {
+    if (getRunState() != RunState::Stopped) return;
+
+    Cpu& cpu = _umpk.getCpu();
+    uint16_t pc = cpu.getProgramCounter();
+    uint8_t opcode = _umpk.getBus().memoryRead(pc);
+
+    if (!Cpu::isCallOpcode(opcode)) {
+        _changeRunState(RunState::Stopped, RunState::Stepping);
+        return;
+    }
+
+    // Back at the next instruction in this frame or an outer one
+    uint16_t next = pc + Disassembler::getInstruction(opcode).length;
+
+    _umpk.getBreakpoints().setTemporary(next, cpu.getStackPointer());
+    _startRunTo();
+}
+
+void Controller::_stepOut() {
+    if (getRunState() != RunState::Stopped) return;
+
+    _steppingOut = true;
+    _stepOutStack = _umpk.getCpu().getStackPointer();
+    _startRunTo();
+}
+
+void Controller::_runTo(uint16_t address) {
+    if (getRunState() != RunState::Stopped) return;
+
+    _umpk.getBreakpoints().setTemporary(address);
+    _startRunTo();
+}
+
+void Controller::_publishSnapshot() {
+    MachineSnapshot& snapshot = _snapshots.back();
+    Cpu& cpu = _umpk.getCpu();
+
+    snapshot.sequence = ++_snapshotSequence;
+    snapshot.cycles = cpu.getCycles();
+
+    snapshot.programCounter = cpu.getProgramCounter();
+    snapshot.stackPointer = cpu.getStackPointer();
+    for (int i = 0; i < 8; i++) snapshot.registers[i] = cpu.getRegister((Cpu::Register)i);
+    snapshot.flags = cpu.getFlags();
+    snapshot.commandRegister = cpu.getCommandRegister();
+    snapshot.interruptsEnabled = cpu.isInterruptsEnabled();
+
+    for (int d = 0; d < 6; d++) {
+        snapshot.display[d] = _umpk.getDisplayDigit(d);
+        snapshot.brightness[d] = _umpk.getDisplayBrightness(d);
+    }
 
-    if (pgCounter == DELAY_FUNC_ADR) {
-        uint16_t delay = cpu.getRegister(Cpu::Register::B);
-        delay = (delay << 8) | cpu.getRegister(Cpu::Register::C);
+    snapshot.ioPort = _umpk.PORT_IO;
+    snapshot.port5In = _umpk.port5InGet();
+    snapshot.port5Out = _umpk.port5OutGet();
+    snapshot.dacValue = _umpk.getDac().getValue();
+    snapshot.dacPort = _umpk.getDacPort();
+    snapshot.adcPort = _umpk.getAdcPort();
 
-        for (int i = 0; i < 0xF000 * delay; i++)
-            ;
+    for (int i = 0; i < (int)HleRoutine::Count; i++) {
+        snapshot.hle[i] = _umpk.isHle((HleRoutine)i);
     }
+
+    snapshot.sliceCycles = _sliceCycles;
+    snapshot.slices = _slices;
+    snapshot.sliceOverruns = _sliceOverruns;
+    snapshot.sliceMicros = _sliceMicros;
+
+    snapshot.speed = _speed;
+    snapshot.achievedHz = _achievedHz;
+    snapshot.jitterMeanMicros = _jitterMeanMicros;
+    snapshot.jitterMaxMicros = _jitterMaxMicros;
+
+    const Breakpoints& breakpoints = _umpk.getBreakpoints();
+    snapshot.breakpointCount = breakpoints.count();
+    for (int i = 0; i < breakpoints.count(); i++) snapshot.breakpoints[i] = breakpoints.at(i);
+    snapshot.breakpointStoppedBy = breakpoints.stoppedBy();
+
+    memcpy(snapshot.portsIn, _umpk.getBus().portsLastIn(), PORTS_COUNT);
+    memcpy(snapshot.portsOut, _umpk.getBus().portsLastOut(), PORTS_COUNT);
+
+    // 4 KB, copying it whole is cheaper than tracking what changed
+    memcpy(snapshot.memory, &_umpk.getBus().romFirst(), MEMORY_SIZE);
+
+    _snapshots.publish();
 }
 
 void Controller::_umpkWork() {
+    configureHostThread(HostThread::Emulation, "umpk-emu");
+
     _umpkMutex.lock();
     _loadSystem();
+    _publishSnapshot();
     _umpkMutex.unlock();
 
-    while (_isUmpkWorking) {
-        if (_isUmpkFreezed)
-            continue;
+    for (;;) {
+        RunState state = _runState.load(std::memory_order_acquire);
+
+        switch (state) {
+        case RunState::ShuttingDown:
+            return;
+
+        case RunState::Stopped:
+            // Stopped time counts neither for pacing nor for the clock
+            _paced = false;
+            _rateValid = false;
+
+            // Commands edit the machine, so they are applied under the
+            // lock like the ones taken at the start of a slice
+            _umpkMutex.lock();
+            if (_applyCommands()) _publishSnapshot();
+            _umpkMutex.unlock();
+
+            {
+                // No CPU is used until another state is set or a command comes
+                std::unique_lock<std::mutex> lock(_stateMutex);
+                _stateChanged.wait(lock, [this] {
+                    return _runState.load(std::memory_order_relaxed) != RunState::Stopped ||
+                           !_commands.empty();
+                });
+            }
+            break;
 
-        _umpkMutex.lock();
-        _umpk.tick();
-        _umpkMutex.unlock();
+        case RunState::Running:
+        case RunState::Stepping:
+        case RunState::RunningTo:
+            _runSlice(state);
+            break;
+        }
+    }
+}
+
+void Controller::_runSlice(RunState state) {
+    auto start = std::chrono::steady_clock::now();
+
+    _umpkMutex.lock();
+
+    // All input of the slice comes in here, so the whole slice runs on
+    // the same keys and machine state
+    _applyCommands();
+    _umpk.applyQueuedEvents();
+
+    Cpu& cpu = _umpk.getCpu();
+    u64 target = cpu.getCycles() + _sliceCycles;
+    bool complete = true;
+    bool stepOut = (state == RunState::RunningTo) && _steppingOut;
 
-        _handleHooks(_umpk.getCpu());
+    while (cpu.getCycles() < target) {
+        bool hleReturned = _umpk.step();
 
-        if (breakpoint == _umpk.getCpu().getProgramCounter())
-            _isUmpkFreezed = true;
+        uint16_t pc = cpu.getProgramCounter();
+
+        // One bit per instruction, hooks and breakpoints are only
+        // looked up on the addresses that have them
+        if (_umpk.isAddressMarked(pc)) {
+            _handleHooks(cpu);
+
+            if (_umpk.getBreakpoints().check(pc) && state != RunState::Stepping) {
+                _changeRunState(state, RunState::Stopped);
+                complete = false;
+                break;
+            }
+        }
+
+        // Returns of deeper calls leave SP at or below the frame's. An HLE
+        // handler pops its routine's frame without a RET opcode.
+        if (stepOut && (hleReturned || Cpu::isReturnOpcode(cpu.getCommandRegister())) &&
+            cpu.getStackPointer() > _stepOutStack) {
+            _changeRunState(state, RunState::Stopped);
+            complete = false;
+            break;
+        }
+
+        if (state == RunState::Stepping) {
+            _changeRunState(RunState::Stepping, RunState::Stopped);
+            complete = false;
+            break;
+        }
+
+        // Stop pressed
+        if (_runState.load(std::memory_order_relaxed) != state) {
+            complete = false;
+            break;
+        }
+    }
+
+    // Cut slices say nothing about the host keeping up
+    if (complete) {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        _sliceMicros =
+            (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        _slices++;
+
+        if (_sliceMicros > _slicePeriodMicros) _sliceOverruns++;
+    }
+
+    // Reached, stopped by a breakpoint or by Stop
+    if (state == RunState::RunningTo && _runState.load(std::memory_order_relaxed) != state) {
+        _clearRunTo();
+    }
+
+    double speed = _speed;
+
+    _publishSnapshot();
+    _umpkMutex.unlock();
+
+    if (complete && state == RunState::Running) _pace(state, speed);
+}
+
+void Controller::_pace(RunState state, double speed) {
+    using namespace std::chrono;
+
+    // Achieved clock measurement window
+    const auto RATE_WINDOW = milliseconds(500);
+
+    // Catch-up limit. Further behind than this the schedule starts over,
+    // the host doesn't race through the backlog.
+    const auto MAX_LAG = milliseconds(100);
+
+    auto now = steady_clock::now();
+    uint64_t cycles = _umpk.getCycles();
+
+    if (!_rateValid) {
+        _rateValid = true;
+        _rateStart = now;
+        _rateCycles = cycles;
+    } else if (now - _rateStart >= RATE_WINDOW) {
+        double seconds = duration<double>(now - _rateStart).count();
+
+        _achievedHz = (uint32_t)((cycles - _rateCycles) / seconds);
+        _rateStart = now;
+        _rateCycles = cycles;
+
+        _jitterMeanMicros = _jitterCount ? (uint32_t)(_jitterSum / _jitterCount) : 0;
+        _jitterMaxMicros = (uint32_t)_jitterMax;
+        _jitterSum = _jitterCount = _jitterMax = 0;
     }
+
+    if (speed <= 0) {
+        _paced = false;
+        return;
+    }
+
+    if (!_paced || _pacedSpeed != speed) {
+        _paced = true;
+        _pacedSpeed = speed;
+        _paceStart = now;
+        _paceCycles = cycles;
+        return;
+    }
+
+    // Due time from the start of the schedule, so rounding and oversleeping
+    // don't add up over slices
+    auto due = _paceStart + duration_cast<steady_clock::duration>(duration<double>(
+        (cycles - _paceCycles) / (UMPK80_CLOCK_HZ * speed)));
+
+    if (now > due + MAX_LAG) {
+        _paceStart = now;
+        _paceCycles = cycles;
+        return;
+    }
+
+    // Woken early by stop or step
+    {
+        std::unique_lock<std::mutex> lock(_stateMutex);
+        bool woken = _stateChanged.wait_until(lock, due, [this, state] {
+            return _runState.load(std::memory_order_relaxed) != state;
+        });
+
+        if (woken) return;
+    }
+
+    // Lateness of the wakeup, what the host scheduler adds to the pacing
+    auto late = steady_clock::now() - due;
+    uint64_t micros = (late.count() > 0) ? duration_cast<microseconds>(late).count() : 0;
+
+    _jitterSum += micros;
+    _jitterCount++;
+    if (micros > _jitterMax) _jitterMax = micros;
+
+    _jitterTotalSum += micros;
+    _jitterTotalCount++;
+    if (micros > _jitterTotalMax) _jitterTotalMax = micros;
 }
 
 void Controller::_copyTestToMemory(uint16_t startAdr, uint8_t *test,
@@ -1,7 +1,13 @@
 #ifndef CONTROLLER_HPP
 #define CONTROLLER_HPP
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
+#include <stdexcept>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -11,9 +17,19 @@
 
 #include "../core/disassembler.hpp"
 #include "../core/dj.hpp"
+#include "../core/ring.hpp"
+#include "../core/triplebuffer.hpp"
 #include "../core/umpk80.hpp"
 
+#include "analog-stream.hpp"
+#include "emulator-options.hpp"
+#include "expansion-modules.hpp"
 #include "gui-app-base.hpp"
+#include "host-thread.hpp"
+#include "printer-capture.hpp"
+#include "ram-image.hpp"
+#include "serial-stream.hpp"
+#include "speaker-stream.hpp"
 
 #ifdef EMULATE_OLD_UMPK
 #define OS_FILE "./data/old.bin"
@@ -21,19 +37,181 @@
 #define OS_FILE "./data/scaned-os-fixed.bin"
 #endif
 
-class Controller {
+#define CONTROLLER_COMMAND_QUEUE_SIZE 256
+
+// Change of the machine state requested by the GUI. The emulation thread
+// applies each one whole at the start of a slice.
+struct ControllerCommand {
+    enum class Type {
+        WriteMemory,           // `data` at `address`
+        SetRegister,           // `value` to `reg`
+        SetFlags,
+        SetProgramCounter,     // `address`
+        SetStackPointer,       // `address`
+        SetPort5In,            // `value`
+        Restart,
+        Refresh,               // only publishes a new snapshot
+        StepOver,              // targets taken where the CPU is once the
+        StepOut,               // commands before them are applied
+        RunTo,                 // `address`
+        AddBreakpoint,         // at `address`, `text` condition, `count` hits,
+                               // `flag` log only
+        RemoveBreakpoint,      // `id`
+        SetBreakpointEnabled,  // `id`, `flag`
+        ResetBreakpointHits,
+        ToggleBreakpoint,      // `address`
+    };
+
+    Type type = Type::Restart;
+    uint16_t address = 0;
+    uint8_t value = 0;
+    Cpu::Register reg = Cpu::Register::A;
+    CpuFlagsMapping flags = {};
+    std::vector<uint8_t> data;
+    std::string text;
+    uint32_t count = 0;
+    int id = 0;
+    bool flag = false;
+};
+
+// Machine state as the GUI sees it. The emulation thread publishes a
+// whole one after every slice and after applying commands, the GUI
+// takes the latest once per frame and reads nothing else, so a frame
+// never shows registers and memory from different instructions.
+struct MachineSnapshot {
+    // Publish count, changes whenever anything may have
+    uint64_t sequence = 0;
+    uint64_t cycles = 0;
+
+    uint16_t programCounter = 0;
+    uint16_t stackPointer = 0;
+    uint8_t  registers[8] = {0};    // by Cpu::Register
+    CpuFlagsMapping flags = {};
+    uint8_t  commandRegister = 0;
+    bool     interruptsEnabled = false;
+
+    uint8_t display[6] = {0};
+    uint8_t brightness[6] = {0};
+
+    uint8_t ioPort = 0;
+    uint8_t port5In = 0;
+    uint8_t port5Out = 0;
+    uint8_t dacValue = 0;
+
+    // Ports of the DAC and ADC modules, -1 - not connected
+    int dacPort = -1;
+    int adcPort = -1;
+
+    // Monitor routines run at a high level, by HleRoutine
+    bool hle[(int)HleRoutine::Count] = {false};
+
+    // Emulated cycles per slice, slices run in full, how many of them
+    // took longer on the host than a frame and how long the last one took
+    uint32_t sliceCycles = 0;
+    uint64_t slices = 0;
+    uint64_t sliceOverruns = 0;
+    uint32_t sliceMicros = 0;
+
+    // Requested clock multiplier (0 - unlimited) and the emulated clock
+    // actually achieved over the last half second of running
+    double   speed = 1.0;
+    uint32_t achievedHz = 0;
+
+    // How late the paced slices started over the same half second,
+    // on average and at worst
+    uint32_t jitterMeanMicros = 0;
+    uint32_t jitterMaxMicros = 0;
+
+    // In address order, and the one that stopped the last run (0 - none)
+    int breakpointCount = 0;
+    Breakpoint breakpoints[BREAKPOINTS_MAX];
+    int breakpointStoppedBy = 0;
+
+    // Last bytes read from and written to each port
+    uint8_t portsIn[PORTS_COUNT] = {0};
+    uint8_t portsOut[PORTS_COUNT] = {0};
+
+    // The whole address space, ROM then RAM
+    uint8_t memory[MEMORY_SIZE] = {0};
+};
+
+// A snapshot as an expression reads it, for watches
+class SnapshotView {
+public:
+    SnapshotView(const MachineSnapshot& snapshot) : _snapshot(snapshot) {}
+
+    u8 reg(Cpu::Register reg) { return _snapshot.registers[(int)reg]; }
+    u16 sp() { return _snapshot.stackPointer; }
+    u16 pc() { return _snapshot.programCounter; }
+    CpuFlagsMapping flags() { return _snapshot.flags; }
+    u64 cycles() { return _snapshot.cycles; }
+
+    u8 memory(u16 adr) { return _snapshot.memory[adr & 0x0FFF]; }
+    u8 portIn(u8 port) { return _snapshot.portsIn[port]; }
+    u8 portOut(u8 port) { return _snapshot.portsOut[port]; }
+
+private:
+    const MachineSnapshot& _snapshot;
+};
+
+class Controller : private BreakpointListener {
 public:
     const uint16_t UMPK_ROM_SIZE = 0x800;
 
+    // State of the emulation thread. It sleeps while Stopped, Stepping
+    // runs one instruction and goes back to Stopped, RunningTo runs
+    // unpaced until the step over, step out or run to target is reached.
+    enum class RunState { Stopped, Running, Stepping, RunningTo, ShuttingDown };
+
 public:
-    Controller(GuiAppBase& gui)
-        : _umpkThread(&Controller::_umpkWork, this), _disasm(nullptr, 0), _gui(gui) {}
+    Controller(GuiAppBase& gui, const EmulatorOptions& options = EmulatorOptions())
+        : _gui(gui), _disasm(nullptr, 0),
+          dj([] { configureHostThread(HostThread::Audio, "umpk-dj"); }),
+          _umpkThread(&Controller::_umpkWork, this) {
+        setFrameRate(options.frameRate);
+        setSpeed(options.speed);
+        for (int i = 0; i < (int)HleRoutine::Count; i++) setHle((HleRoutine)i, options.hle[i]);
+        _markHooks();
+        setSoundSource(options.soundSource);
+        setupModules(options);
+        setupSerial(options);
+        setupPrinter(options);
+        setupAnalog(options);
+        setupBreakpoints(options);
+
+        if (!options.ramImageFile.empty()) {
+            try {
+                attachRamImage(options.ramImageFile);
+            } catch (const std::exception& e) {
+                std::cout << "[ERR] " << e.what() << ". RAM is not persistent.\n";
+            }
+        }
+    }
 
     ~Controller() {
-        _umpkMutex.lock();
-        _isUmpkWorking = false;
-        _umpkMutex.unlock();
+        _setRunState(RunState::ShuttingDown);
         _umpkThread.join();
+
+        if (_jitterTotalCount > 0) {
+            std::cout << "[INFO] Pacing jitter: mean " << _jitterTotalSum / _jitterTotalCount
+                      << " us, max " << _jitterTotalMax << " us over " << _jitterTotalCount
+                      << " slices.\n";
+        }
+
+        _umpk.setSpeakerListener(nullptr);
+        _speakerStream.reset();
+
+        _umpk.getUsart().setHost(nullptr);
+        _serialStream.reset();
+
+        _printerCapture.reset();
+
+        _umpk.getAdc().setSource(nullptr);
+        _adcSource.reset();
+        _dacRecorder.reset();
+
+        _umpk.getBus().memoryAttach(nullptr);
+        _ramImage.close();
     }
 
     void decompileToFile(std::string filename, uint16_t fromAdr, uint16_t len);
@@ -43,14 +221,33 @@ public:
     void onBtnNextCommand();
     void onBtnReset();
 
+    // Runs a CALL, Ccc or RST together with the routine it enters,
+    // anything else as onBtnNextCommand
+    void onBtnStepOver();
+    // Runs until a return leaves the routine the CPU is in
+    void onBtnStepOut();
+    // Runs until `address` is reached
+    void runTo(uint16_t address);
+
     void setUmpkKey(KeyboardKey key, bool value);
-    bool getUmpkKeyState(KeyboardKey key) { return _umpk.getKeyState(key); }
 
-    bool isUmpkRunning() { return !_isUmpkFreezed; }
+    bool isUmpkRunning() {
+        RunState state = getRunState();
+        return state == RunState::Running || state == RunState::RunningTo;
+    }
+
+    RunState getRunState() const { return _runState.load(std::memory_order_acquire); }
+
+    // Takes the latest snapshot published by the emulation thread.
+    // GUI thread only, once per frame before rendering.
+    void refreshSnapshot() { _snapshots.acquire(); }
+
+    // Valid until the next refreshSnapshot
+    const MachineSnapshot& snapshot() const { return _snapshots.front(); }
 
-    uint8_t getDisplayDigit(int digit) { return _umpk.getDisplayDigit(digit); }
+    uint8_t getDisplayDigit(int digit) { return snapshot().display[digit]; }
 
-    uint8_t port5Out() { return _umpk.port5OutGet(); }
+    uint8_t port5Out() { return snapshot().port5Out; }
     void port5In(uint8_t data);
 
     void setCpuFlags(CpuFlagsMapping flags);
@@ -59,9 +256,67 @@ public:
 
     void setMemory(uint16_t index, uint8_t data);
 
+    void setDisplayFastPath(bool enabled);
+
+    // Runs a monitor routine at a high level or as the ROM code
+    void setHle(HleRoutine routine, bool enabled);
+    bool isHle(HleRoutine routine) { return snapshot().hle[(int)routine]; }
+
+    // Slices are one frame at `hz` of emulated cycles long
+    void setFrameRate(uint32_t hz);
+
+    // Paces the emulated clock at `multiplier` times the real one,
+    // 0 runs it as fast as the host can
+    void setSpeed(double multiplier);
+
+    void setSoundSource(SoundSource source);
+
+    // Connects the timer and PPI modules as described by the options
+    void setupModules(const EmulatorOptions& options);
+
+    // Connects the 8251 USART module and its host streams, a stream
+    // that can't be opened is reported and left unconnected
+    void setupSerial(const EmulatorOptions& options);
+
+    // Connects the printer and its capture thread, an output file that
+    // can't be opened is reported and the printer is left unconnected
+    void setupPrinter(const EmulatorOptions& options);
+
+    // Null when no printer is connected
+    PrinterCapture* printer() { return _printerCapture.get(); }
+
+    // Connects the DAC and its recorder and the ADC and its source,
+    // a file or source that can't be opened is reported and left out
+    void setupAnalog(const EmulatorOptions& options);
+
+    void setupBreakpoints(const EmulatorOptions& options);
+
+    // The breakpoint calls are queued like the other commands, ids and
+    // hit counts show up in the next snapshot.
+    // False when the condition doesn't compile (see Expression::compile)
+    // or the snapshot's table is full.
+    bool addBreakpoint(uint16_t address, const std::string& condition = "",
+                       uint32_t hitThreshold = 1, bool logOnly = false);
+    void removeBreakpoint(int id);
+    void setBreakpointEnabled(int id, bool enabled);
+    void resetBreakpointHits();
+    // Removes the breakpoints at `address`, or adds a plain one if none
+    void toggleBreakpoint(uint16_t address);
+    // First breakpoint at `address` in the snapshot, nullptr - none
+    const Breakpoint* breakpointAt(uint16_t address) const;
+
+    // Null when no DAC is connected
+    DacRecorder* dacRecorder() { return _dacRecorder.get(); }
+
+    bool isDisplayFastPath() { return isHle(HleRoutine::DisplayScan); }
+
+    // Backs the address space with a memory-mapped file, so RAM survives
+    // restarts. Throws std::runtime_error if the file can't be mapped.
+    void attachRamImage(const std::string& path);
+
     uint16_t getSystemPG() { 
-        uint16_t high = _umpk.getBus().memoryRead(0xBBF);
-        uint8_t  low  = _umpk.getBus().memoryRead(0xBBE);
+        uint16_t high = snapshot().memory[0xBBF];
+        uint8_t  low  = snapshot().memory[0xBBE];
 
         return (high << 8) | low; 
     }
@@ -72,26 +327,27 @@ public:
     }
 
     uint8_t getRegister(Cpu::Register reg) {
-        return _umpk.getCpu().getRegister(reg);
+        return snapshot().registers[(int)reg];
     }
 
     void setRegister(Cpu::Register reg, uint8_t value) {
-        _umpkMutex.lock();
-        _umpk.getCpu().setRegister(reg, value);
-        _umpkMutex.unlock();
-    }
+        ControllerCommand command;
+        command.type = ControllerCommand::Type::SetRegister;
+        command.reg = reg;
+        command.value = value;
 
-    std::vector<uint8_t> readBinaryFile(std::string path);
+        _sendCommand(std::move(command));
+    }
 
-    void loadProgramToMemory(uint16_t position, std::vector<uint8_t> &program);
+    static std::vector<uint8_t> readBinaryFile(std::string path);
 
-    Umpk80 &umpk() { return _umpk; }
+    // "Breakpoint <id> at <address>h, hit <n>: <registers>"
+    static std::string breakpointHitToString(const Breakpoint& breakpoint, Cpu& cpu);
 
-    const uint8_t *getRam() { return &(_umpk.getBus().ramFirst()); }
-    const uint8_t *getRom() { return &(_umpk.getBus().romFirst()); }
+    void loadProgramToMemory(uint16_t position, std::vector<uint8_t> &program);
 
-    // FIXME 
-    int breakpoint = -1;
+    const uint8_t *getRam() { return snapshot().memory + 0x800; }
+    const uint8_t *getRom() { return snapshot().memory; }
 
 private:
     GuiAppBase& _gui;
@@ -99,17 +355,118 @@ private:
     Umpk80 _umpk;
     Disassembler _disasm;
     Dj dj;
+    RamImage _ramImage;
 
-    std::thread _umpkThread;
+    SoundSource _soundSource = SoundSource::Hook;
+    std::unique_ptr<SpeakerStream> _speakerStream;
+    std::unique_ptr<SerialStream> _serialStream;
+    std::unique_ptr<PrinterCapture> _printerCapture;
+    std::unique_ptr<DacRecorder> _dacRecorder;
+    std::unique_ptr<AnalogSource> _adcSource;
+
+    // Last key states sent by the GUI thread
+    bool _guiKeys[(int)KeyboardKey::ST + 1] = {false};
+
+    // Taken by the emulation thread for a whole slice, reconfiguring
+    // the machine (modules, sound, display path) waits for its end
     std::mutex _umpkMutex;
 
-    bool _isUmpkFreezed = true;
-    bool _isUmpkWorking = true;
+    // Under _umpkMutex
+    uint32_t _sliceCycles = UMPK80_CLOCK_HZ / 60;
+    uint32_t _slicePeriodMicros = 1000000 / 60;
+    double _speed = 1.0;
+
+    // Under _umpkMutex. Step out stops after a return that leaves SP
+    // above _stepOutStack, step over and run to stop at the temporary
+    // breakpoint.
+    bool _steppingOut = false;
+    uint16_t _stepOutStack = 0;
+
+    // Emulation thread only, published with the snapshot
+    uint64_t _slices = 0;
+    uint64_t _sliceOverruns = 0;
+    uint32_t _sliceMicros = 0;
+    uint32_t _achievedHz = 0;
+
+    // Emulation thread only. Slices are due at _paceStart plus the time
+    // the cycles run since _paceCycles take at _pacedSpeed, the schedule
+    // restarts on every start, speed change and when it falls too far behind.
+    bool _paced = false;
+    double _pacedSpeed = 0;
+    std::chrono::steady_clock::time_point _paceStart;
+    uint64_t _paceCycles = 0;
+
+    // Emulation thread only, window of the achieved clock measurement
+    bool _rateValid = false;
+    std::chrono::steady_clock::time_point _rateStart;
+    uint64_t _rateCycles = 0;
+
+    // Emulation thread only, lateness of the paced slices in
+    // microseconds over the window and since the start
+    uint32_t _jitterMeanMicros = 0;
+    uint32_t _jitterMaxMicros = 0;
+    uint64_t _jitterSum = 0;
+    uint64_t _jitterCount = 0;
+    uint64_t _jitterMax = 0;
+    uint64_t _jitterTotalSum = 0;
+    uint64_t _jitterTotalCount = 0;
+    uint64_t _jitterTotalMax = 0;
+
+    // GUI thread to emulation thread, see _sendCommand
+    SpscRing<ControllerCommand, CONTROLLER_COMMAND_QUEUE_SIZE> _commands;
+
+    // Written under _stateMutex, read without it by the emulation loop
+    std::atomic<RunState> _runState{RunState::Stopped};
+    std::mutex _stateMutex;
+    std::condition_variable _stateChanged;
+
+    // Emulation thread to GUI thread, see _publishSnapshot
+    TripleBuffer<MachineSnapshot> _snapshots;
+    uint64_t _snapshotSequence = 0;
+
+    // Last, so it starts once everything it uses is constructed
+    std::thread _umpkThread;
 
 private:
+    // Queues a command for the emulation thread, which applies it
+    // at the start of the next slice. Called by the emulation thread itself (from a
+    // hook) it is applied right away.
+    void _sendCommand(ControllerCommand&& command);
+    // Emulation thread, with _umpkMutex held. True if there were any
+    bool _applyCommands();
+    void _applyCommand(ControllerCommand& command);
+    void _addBreakpoint(const ControllerCommand& command);
+    void _toggleBreakpoint(uint16_t address);
+
+    // Emulation thread, with _umpkMutex held
+    void _publishSnapshot();
+
+    void _setRunState(RunState state);
+    // Moves from `from` to `to` unless another transition came first
+    bool _changeRunState(RunState from, RunState to);
+
     void _loadSystem();
+    // Marks the addresses _handleHooks looks at
+    void _markHooks();
+    // Only called on marked addresses
     void _handleHooks(Cpu &cpu);
+    void breakpointLogged(const Breakpoint& breakpoint) override;
+    // Publishes the edits made under _umpkMutex while stopped too
+    void _refreshSnapshot();
+    // Emulation thread, with _umpkMutex held. Step over, step out and
+    // run to only start from Stopped.
+    void _stepOver();
+    void _stepOut();
+    void _runTo(uint16_t address);
+    // Leaves Stopped for RunningTo with the target set
+    bool _startRunTo();
+    void _clearRunTo();
     void _umpkWork();
+    // One frame of emulated cycles, cut short by a step, a breakpoint
+    // or a state change
+    void _runSlice(RunState state);
+    // Measures the achieved clock and sleeps until the next slice is due
+    void _pace(RunState state, double speed);
     void _copyTestToMemory(uint16_t startAdr, uint8_t *test, size_t size);
 };
 
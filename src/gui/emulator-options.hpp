@@ -0,0 +1,416 @@
+#ifndef UMPK_80_EMU_UI_EMULATOR_OPTIONS_HPP
+#define UMPK_80_EMU_UI_EMULATOR_OPTIONS_HPP
+
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../core/hle.hpp"
+
+#include "host-thread.hpp"
+
+// Above it a slice would be under a microsecond and a couple of cycles
+#define FRAME_RATE_MAX 1000000
+
+enum class SoundSource {
+    // Tone of the monitor's sound subroutine (0447h)
+    Hook,
+    // Waveform synthesized from the speaker port
+    Speaker,
+};
+
+// Breakpoint given on the command line, see Breakpoints::add
+struct BreakpointOption {
+    uint16_t address = 0;
+    std::string condition;
+    uint32_t hits = 1;
+    bool logOnly = false;
+};
+
+struct EmulatorOptions {
+    // User program for the compact mode
+    std::string programFile;
+
+    // File that backs the address space, empty to keep memory in-process
+    std::string ramImageFile;
+
+    // Monitor routines run at a high level, by HleRoutine
+    bool hle[(int)HleRoutine::Count] = {false};
+
+    SoundSource soundSource = SoundSource::Hook;
+
+    // Run without a window or an audio device
+    bool headless = false;
+
+    // Headless run length in emulated cycles (10 s at 2 MHz)
+    uint64_t cycles = 20000000;
+
+    // Headless entry point of the user program
+    uint16_t startAddress = 0x0800;
+
+    // Headless sound output, empty to discard it
+    std::string wavFile;
+
+    // 8253 timer module: base port (-1 - not connected), CPU cycles per
+    // timer clock and the RST raised by each counter's OUT (-1 - none)
+    int timerPort = -1;
+    uint32_t timerClockDivider = 1;
+    int timerRst[3] = {-1, -1, -1};
+
+    // 8251 USART module: base port (-1 - not connected), baud rate,
+    // RST raised by RxRDY (-1 - none) and the host side of the line
+    int serialPort = -1;
+    uint32_t serialBaud = 9600;
+    int serialRst = -1;
+    std::string serialIn;
+    std::string serialOut;
+    bool serialPty = false;
+
+    // 8255 PPI module: base port (-1 - not connected), cycles after which
+    // the peripheral acknowledges mode 1/2 output (0 - never) and the RST
+    // raised by INTR of ports A and B (-1 - none)
+    int ppiPort = -1;
+    uint32_t ppiAutoAck = 0;
+    int ppiRst[2] = {-1, -1};
+
+    // Printer: base port (-1 - not connected), file the output is
+    // appended to (empty - only the printer window) and page length
+    int printerPort = -1;
+    std::string printerOut;
+    uint32_t printerPageLines = 66;
+
+    // DAC: output port (-1 - not connected) and the file its writes are
+    // recorded to (".csv" - text, otherwise binary, empty - plot only)
+    int dacPort = -1;
+    std::string dacOut;
+
+    // ADC: input port (-1 - not connected), fed from a raw 8-bit sample
+    // file played at `adcRate` or from a "<shape>:<Hz>" generator
+    int adcPort = -1;
+    std::string adcIn;
+    uint32_t adcRate = 8000;
+    std::string adcWave;
+
+    // Display refresh rate, the emulation thread runs one frame of
+    // emulated cycles per slice
+    uint32_t frameRate = 60;
+
+    // Emulated clock relative to the real 2 MHz, 0 - as fast as the host can
+    double speed = 1.0;
+
+    // Set before the run starts, in both modes
+    std::vector<BreakpointOption> breakpoints;
+
+    // Headless: expressions printed with the final state, and one that is
+    // timed (see Expression) on it
+    std::vector<std::string> watches;
+    std::string benchExpression;
+
+    // Cores and scheduling of the emulation, audio and render threads
+    HostThreadSettings emuThread;
+    HostThreadSettings audioThread;
+    HostThreadSettings renderThread;
+};
+
+// "all", "none" or a comma-separated list of HLE routine names,
+// false on an unknown name
+inline bool parseHleRoutines(const std::string& list, bool* hle) {
+    bool all = (list == "all");
+
+    if (all || list == "none") {
+        for (int i = 0; i < (int)HleRoutine::Count; i++) hle[i] = all;
+        return true;
+    }
+
+    size_t start = 0;
+
+    while (start <= list.size()) {
+        size_t comma = list.find(',', start);
+        std::string name = list.substr(start, comma - start);
+        int i = 0;
+
+        while (i < (int)HleRoutine::Count && name != hleRoutineInfo((HleRoutine)i).name) i++;
+
+        if (i == (int)HleRoutine::Count) return false;
+
+        hle[i] = true;
+
+        if (comma == std::string::npos) break;
+        start = comma + 1;
+    }
+
+    return true;
+}
+
+// "<hex address>[,hits=<n>][,log][,if=<condition>]", the condition
+// goes to the end, false on a bad spec. The condition itself is only
+// checked when the breakpoint is set.
+inline bool parseBreakpointOption(const std::string& spec, BreakpointOption& option) {
+    size_t comma = spec.find(',');
+    std::string address = spec.substr(0, comma);
+    char* end = nullptr;
+
+    option.address = (uint16_t)std::strtoul(address.c_str(), &end, 16);
+    if (address.empty() || *end != 0) return false;
+
+    while (comma != std::string::npos) {
+        size_t start = comma + 1;
+
+        if (spec.compare(start, 3, "if=") == 0) {
+            option.condition = spec.substr(start + 3);
+            break;
+        }
+
+        comma = spec.find(',', start);
+        std::string field = spec.substr(start, comma - start);
+
+        if (field == "log") {
+            option.logOnly = true;
+        } else if (field.compare(0, 5, "hits=") == 0 && field.size() > 5) {
+            option.hits = (uint32_t)std::strtoul(field.c_str() + 5, nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Parses --<thread>-cpu and --<thread>-sched, false if `arg` is neither
+inline bool parseThreadOption(const std::string& arg, const std::string& thread,
+                              const char* value, HostThreadSettings& settings) {
+    if (arg == "--" + thread + "-cpu") {
+        settings.cpu = std::atoi(value);
+    } else if (arg == "--" + thread + "-sched") {
+        if (!parseThreadPolicy(value, settings)) {
+            std::cout << "[WARN] Bad scheduling \"" << value
+                      << "\", expected fifo[:<1-99>] or nice:<-20-19>.\n";
+        }
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+// umpk-80-emu-ui [--ram-image <file>] [--display-fast-path]
+//                [--hle all|none|scan,delay1ms,delay,multiply,decode]
+//                [--sound hook|speaker] [--frame-rate <Hz>] [--speed <x>|max]
+//                [--emu-cpu|--audio-cpu|--render-cpu <n>]
+//                [--emu-sched|--audio-sched|--render-sched fifo[:<prio>]|nice:<n>]
+//                [program.bin]
+// umpk-80-emu-ui --headless [--cycles <n>] [--start <hex>] [--wav <file>]
+//                [--display-fast-path] [--sound hook|speaker]
+//                [--watch <expression>]... [--bench-expression <expression>]
+//                [program.bin]
+// Expansion modules (both modes):
+//                [--timer <hex port>] [--timer-clock <cycles>]
+//                [--timer-rst <counter>:<rst>]...
+//                [--serial <hex port>] [--serial-baud <n>] [--serial-rst <rst>]
+//                [--serial-in <file|->] [--serial-out <file|->] [--serial-pty]
+//                [--ppi <hex port>] [--ppi-ack <cycles>] [--ppi-rst a|b:<rst>]...
+//                [--printer <hex port>] [--printer-out <file|->] [--printer-page <lines>]
+//                [--dac <hex port>] [--dac-out <file>]
+//                [--adc <hex port>] [--adc-in <file>] [--adc-rate <Hz>]
+//                [--adc-wave sine|square|saw|triangle:<Hz>]
+// Breakpoints (both modes):
+//                [--break <hex address>[,hits=<n>][,log][,if=<condition>]]...
+// Port as the manual writes it, e.g. "04h"
+inline std::string portToString(int port) {
+    const char* digits = "0123456789ABCDEF";
+
+    return std::string(1, digits[(port >> 4) & 0x0F]) + digits[port & 0x0F] + "h";
+}
+
+// Expansion module as mapped by its port option
+struct ModulePorts {
+    const char* name;
+    int* port;
+    int count;
+    bool in;
+    bool out;
+};
+
+// Unmaps the modules whose ports run past FFh or overlap an earlier one.
+// Clashes with the built-in ports depend on the core build, they are
+// reported when the modules are connected.
+inline void checkModulePorts(EmulatorOptions& options) {
+    ModulePorts modules[] = {
+        { "timer",       &options.timerPort,   4, true,  true  },
+        { "serial line", &options.serialPort,  2, true,  true  },
+        { "PPI",         &options.ppiPort,     4, true,  true  },
+        { "printer",     &options.printerPort, 2, true,  true  },
+        { "DAC",         &options.dacPort,     1, false, true  },
+        { "ADC",         &options.adcPort,     1, true,  false },
+    };
+    const int count = (int)(sizeof(modules) / sizeof(modules[0]));
+
+    for (int i = 0; i < count; i++) {
+        ModulePorts& module = modules[i];
+        int first = *module.port;
+
+        if (first < 0) continue;
+
+        if (first + module.count > 0x100) {
+            std::cout << "[WARN] Ports of " << module.name << " at " << portToString(first)
+                      << " run past FFh, " << module.name << " is not connected.\n";
+            *module.port = -1;
+            continue;
+        }
+
+        for (int j = 0; j < i; j++) {
+            const ModulePorts& other = modules[j];
+            int otherFirst = *other.port;
+
+            if (otherFirst < 0 || first >= otherFirst + other.count || otherFirst >= first + module.count)
+                continue;
+            if (!(module.in && other.in) && !(module.out && other.out)) continue;
+
+            std::cout << "[WARN] Ports of " << other.name << " and " << module.name << " overlap at "
+                      << portToString(first > otherFirst ? first : otherFirst) << ", "
+                      << module.name << " is not connected.\n";
+            *module.port = -1;
+            break;
+        }
+    }
+}
+
+inline EmulatorOptions parseEmulatorOptions(int argc, char* argv[]) {
+    EmulatorOptions options;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--ram-image" && i + 1 < argc) {
+            options.ramImageFile = argv[++i];
+        } else if (arg == "--display-fast-path") {
+            options.hle[(int)HleRoutine::DisplayScan] = true;
+        } else if (arg == "--hle" && i + 1 < argc) {
+            std::string list = argv[++i];
+
+            if (!parseHleRoutines(list, options.hle)) {
+                std::cout << "[WARN] Bad HLE routines \"" << list
+                          << "\", expected all, none or scan,delay1ms,delay,multiply,decode.\n";
+            }
+        } else if (arg == "--sound" && i + 1 < argc) {
+            std::string source = argv[++i];
+            options.soundSource = (source == "speaker") ? SoundSource::Speaker
+                                                        : SoundSource::Hook;
+        } else if (arg == "--frame-rate" && i + 1 < argc) {
+            std::string rate = argv[++i];
+            unsigned long hz = std::strtoul(rate.c_str(), nullptr, 10);
+
+            if (hz == 0 || hz > FRAME_RATE_MAX) {
+                std::cout << "[WARN] Bad frame rate \"" << rate << "\", using 60 Hz.\n";
+                hz = 60;
+            }
+
+            options.frameRate = (uint32_t)hz;
+        } else if (arg == "--speed" && i + 1 < argc) {
+            std::string speed = argv[++i];
+            options.speed = (speed == "max") ? 0.0 : std::atof(speed.c_str());
+
+            if (options.speed < 0) {
+                std::cout << "[WARN] Bad speed \"" << speed << "\", running at 1x.\n";
+                options.speed = 1.0;
+            }
+        } else if (i + 1 < argc && parseThreadOption(arg, "emu", argv[i + 1], options.emuThread)) {
+            i++;
+        } else if (i + 1 < argc && parseThreadOption(arg, "audio", argv[i + 1], options.audioThread)) {
+            i++;
+        } else if (i + 1 < argc && parseThreadOption(arg, "render", argv[i + 1], options.renderThread)) {
+            i++;
+        } else if (arg == "--headless") {
+            options.headless = true;
+        } else if (arg == "--cycles" && i + 1 < argc) {
+            options.cycles = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--start" && i + 1 < argc) {
+            options.startAddress = (uint16_t)std::strtoul(argv[++i], nullptr, 16);
+        } else if (arg == "--wav" && i + 1 < argc) {
+            options.wavFile = argv[++i];
+        } else if (arg == "--watch" && i + 1 < argc) {
+            options.watches.push_back(argv[++i]);
+        } else if (arg == "--bench-expression" && i + 1 < argc) {
+            options.benchExpression = argv[++i];
+        } else if (arg == "--timer" && i + 1 < argc) {
+            options.timerPort = (int)(std::strtoul(argv[++i], nullptr, 16) & 0xFF);
+        } else if (arg == "--timer-clock" && i + 1 < argc) {
+            options.timerClockDivider = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--timer-rst" && i + 1 < argc) {
+            std::string wiring = argv[++i];
+            size_t colon = wiring.find(':');
+            int counter = std::atoi(wiring.substr(0, colon).c_str());
+
+            if (colon == std::string::npos || counter < 0 || counter > 2) {
+                std::cout << "[WARN] Bad timer interrupt \"" << wiring << "\", expected <counter>:<rst>.\n";
+            } else {
+                options.timerRst[counter] = std::atoi(wiring.c_str() + colon + 1) & 0x07;
+            }
+        } else if (arg == "--serial" && i + 1 < argc) {
+            options.serialPort = (int)(std::strtoul(argv[++i], nullptr, 16) & 0xFF);
+        } else if (arg == "--serial-baud" && i + 1 < argc) {
+            options.serialBaud = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--serial-rst" && i + 1 < argc) {
+            options.serialRst = std::atoi(argv[++i]) & 0x07;
+        } else if (arg == "--serial-in" && i + 1 < argc) {
+            options.serialIn = argv[++i];
+        } else if (arg == "--serial-out" && i + 1 < argc) {
+            options.serialOut = argv[++i];
+        } else if (arg == "--serial-pty") {
+            options.serialPty = true;
+        } else if (arg == "--ppi" && i + 1 < argc) {
+            options.ppiPort = (int)(std::strtoul(argv[++i], nullptr, 16) & 0xFF);
+        } else if (arg == "--ppi-ack" && i + 1 < argc) {
+            options.ppiAutoAck = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--ppi-rst" && i + 1 < argc) {
+            std::string wiring = argv[++i];
+            char port = wiring.empty() ? 0 : (char)std::tolower(wiring[0]);
+
+            if (wiring.size() < 3 || wiring[1] != ':' || (port != 'a' && port != 'b')) {
+                std::cout << "[WARN] Bad PPI interrupt \"" << wiring << "\", expected a|b:<rst>.\n";
+            } else {
+                options.ppiRst[port - 'a'] = std::atoi(wiring.c_str() + 2) & 0x07;
+            }
+        } else if (arg == "--printer" && i + 1 < argc) {
+            options.printerPort = (int)(std::strtoul(argv[++i], nullptr, 16) & 0xFF);
+        } else if (arg == "--printer-out" && i + 1 < argc) {
+            options.printerOut = argv[++i];
+        } else if (arg == "--printer-page" && i + 1 < argc) {
+            options.printerPageLines = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--dac" && i + 1 < argc) {
+            options.dacPort = (int)(std::strtoul(argv[++i], nullptr, 16) & 0xFF);
+        } else if (arg == "--dac-out" && i + 1 < argc) {
+            options.dacOut = argv[++i];
+        } else if (arg == "--adc" && i + 1 < argc) {
+            options.adcPort = (int)(std::strtoul(argv[++i], nullptr, 16) & 0xFF);
+        } else if (arg == "--adc-in" && i + 1 < argc) {
+            options.adcIn = argv[++i];
+        } else if (arg == "--adc-rate" && i + 1 < argc) {
+            options.adcRate = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--adc-wave" && i + 1 < argc) {
+            options.adcWave = argv[++i];
+        } else if (arg == "--break" && i + 1 < argc) {
+            std::string spec = argv[++i];
+            BreakpointOption breakpoint;
+
+            if (!parseBreakpointOption(spec, breakpoint)) {
+                std::cout << "[WARN] Bad breakpoint \"" << spec
+                          << "\", expected <hex address>[,hits=<n>][,log][,if=<condition>].\n";
+            } else {
+                options.breakpoints.push_back(breakpoint);
+            }
+        } else if (arg.size() > 2 && arg.compare(0, 2, "--") == 0) {
+            std::cout << "[WARN] Unknown option \"" << arg << "\" ignored.\n";
+        } else {
+            options.programFile = arg;
+        }
+    }
+
+    checkModulePorts(options);
+    return options;
+}
+
+#endif // UMPK_80_EMU_UI_EMULATOR_OPTIONS_HPP
@@ -0,0 +1,37 @@
+#ifndef UMPK_80_EMU_UI_EXPANSION_MODULES_HPP
+#define UMPK_80_EMU_UI_EXPANSION_MODULES_HPP
+
+#include <iostream>
+
+#include "../core/umpk80.hpp"
+
+#include "emulator-options.hpp"
+
+// Warns when a module stays unmapped because a built-in device or
+// another module already holds one of its ports
+inline void warnPortsTaken(bool mapped, const char* name, int port) {
+    if (mapped) return;
+
+    std::cout << "[WARN] Ports of " << name << " at " << portToString(port) << " are taken, "
+              << name << " is not connected.\n";
+}
+
+// Maps and wires the expansion modules that need no host resources.
+// The serial line is connected separately, it owns host streams.
+inline void connectExpansionModules(Umpk80& umpk, const EmulatorOptions& options) {
+    warnPortsTaken(umpk.setTimerPort(options.timerPort), "timer", options.timerPort);
+    umpk.getTimer().setClockDivider(options.timerClockDivider);
+
+    for (int i = 0; i < TIMER_COUNTERS; i++) {
+        umpk.getTimer().setInterrupt(i, options.timerRst[i]);
+    }
+
+    warnPortsTaken(umpk.setPpiPort(options.ppiPort), "PPI", options.ppiPort);
+
+    for (int i = 0; i < 2; i++) {
+        umpk.getPpi().setAutoAcknowledge(i, options.ppiAutoAck);
+        umpk.getPpi().setInterrupt(i, options.ppiRst[i]);
+    }
+}
+
+#endif // UMPK_80_EMU_UI_EXPANSION_MODULES_HPP
@@ -20,8 +20,10 @@
 
 class GuiAppCompact : public GuiAppBase {
 public:
-    GuiAppCompact(const std::string &userProgramFilepath)
-        : m_controller(*this) {
+    GuiAppCompact(const EmulatorOptions &options)
+        : m_controller(*this, options) {
+        const std::string &userProgramFilepath = options.programFile;
+
         if (userProgramFilepath.substr(
                 userProgramFilepath.find_last_of(".") + 1) != "bin") {
             std::cout << "[ERR] \"" << userProgramFilepath << "\" The file path must have a .bin extension.\n";
@@ -61,6 +63,9 @@ public:
     }
 
     void start() {
+        // Keeps its name, it's the one the process is listed by
+        configureHostThread(HostThread::Render, nullptr);
+
         init();
 
         while (m_window.isOpen()) {
@@ -88,6 +93,9 @@ private:
     void update() {
         ImGui::SFML::Update(m_window, m_deltaClock.restart());
 
+        // Every component of this frame reads the same machine state
+        m_controller.refreshSnapshot();
+
         auto m_windowSize = sf::Vector2i(m_window.getSize());
 
         ImGui::SetNextWindowSize(
@@ -8,21 +8,26 @@
 #include <vector>
 
 #include "components/ui/display/ui-display.hpp"
+#include "components/ui/ui-analog.hpp"
+#include "components/ui/ui-breakpoints.hpp"
 #include "components/ui/ui-cmd-table.hpp"
 #include "components/ui/ui-cpu-control.hpp"
 #include "components/ui/ui-decompiler.hpp"
 #include "components/ui/ui-io-register.hpp"
 #include "components/ui/ui-keyboard.hpp"
 #include "components/ui/ui-listing.hpp"
+#include "components/ui/ui-printer.hpp"
 #include "components/ui/ui-program-loader.hpp"
 #include "components/ui/ui-rom.hpp"
+#include "components/ui/ui-watch.hpp"
 
 #include "controller.hpp"
 #include "gui-app-base.hpp"
 
 class GuiApp : public GuiAppBase {
 public:
-    GuiApp() : m_controller(*this) {
+    GuiApp(const EmulatorOptions& options = EmulatorOptions())
+        : m_controller(*this, options) {
         m_window.create(sf::VideoMode(1280, 720), "UMPK-80 Emulator");
         ImGui::SFML::Init(m_window);
 
@@ -34,6 +39,8 @@ public:
         m_components.push_back(std::make_pair("Display", new UiDisplay(m_controller)));
         m_components.push_back(std::make_pair("Keyboard", new UiKeyboard(m_controller)));
         m_components.push_back(std::make_pair("Listing", new UiOsListing(m_controller)));
+        m_components.push_back(std::make_pair("Breakpoints", new UiBreakpoints(m_controller)));
+        m_components.push_back(std::make_pair("Watch", new UiWatch(m_controller)));
         m_components.push_back(std::make_pair("IO", new UiIoRegister(m_controller)));
         m_components.push_back(std::make_pair("Disassembler", new UiDecompilerWindow(m_controller)));
         m_components.push_back(std::make_pair("Program Loader", new UiProgramLoader(m_controller)));
@@ -41,6 +48,8 @@ public:
         m_components.push_back(std::make_pair("RAM", new UiRam(m_controller)));
         m_components.push_back(std::make_pair("Cpu Control", new UiCpuControl(m_controller)));
         m_components.push_back(std::make_pair("Stack", new UiStack(m_controller)));
+        m_components.push_back(std::make_pair("Printer", new UiPrinter(m_controller)));
+        m_components.push_back(std::make_pair("Analog", new UiAnalog(m_controller)));
     }
 
     virtual ~GuiApp() {
@@ -50,6 +59,9 @@ public:
     }
 
     void start() {
+        // Keeps its name, it's the one the process is listed by
+        configureHostThread(HostThread::Render, nullptr);
+
         init();
 
         while (m_window.isOpen()) {
@@ -79,6 +91,9 @@ private:
     void update() {
         ImGui::SFML::Update(m_window, m_deltaClock.restart());
 
+        // Every component of this frame reads the same machine state
+        m_controller.refreshSnapshot();
+
         const ImGuiViewport* viewport = ImGui::GetMainViewport();
         ImGui::SetNextWindowPos(viewport->WorkPos);
         ImGui::SetNextWindowSize(viewport->WorkSize);
@@ -136,6 +151,14 @@ private:
         if (ImGui::IsKeyPressed(ImGuiKey_F10)) {
             m_controller.onBtnNextCommand();
         }
+
+        if (ImGui::IsKeyPressed(ImGuiKey_F11)) {
+            if (ImGui::GetIO().KeyShift) {
+                m_controller.onBtnStepOut();
+            } else {
+                m_controller.onBtnStepOver();
+            }
+        }
     }
 
     void handleEvents() {
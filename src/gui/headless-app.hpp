@@ -0,0 +1,337 @@
+#ifndef UMPK_80_EMU_UI_HEADLESS_APP_HPP
+#define UMPK_80_EMU_UI_HEADLESS_APP_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "../core/umpk80.hpp"
+
+#include "analog-stream.hpp"
+#include "controller.hpp"
+#include "emulator-options.hpp"
+#include "expansion-modules.hpp"
+#include "gui-app-base.hpp"
+#include "printer-capture.hpp"
+#include "serial-stream.hpp"
+#include "wav-recorder.hpp"
+
+// Runs the emulator without a window or an audio device.
+// Boots the monitor, starts the user program and executes a fixed number
+// of emulated cycles as fast as possible, optionally rendering the sound
+// into a WAV file.
+class HeadlessApp : public GuiAppBase, private BreakpointListener {
+public:
+    HeadlessApp(const EmulatorOptions &options) : m_options(options) {}
+
+    void start() override {
+        if (!_loadSystem()) return;
+
+        if (!m_options.wavFile.empty()) {
+            try {
+                m_recorder.reset(new WavRecorder(m_options.wavFile, UMPK80_CLOCK_HZ));
+            } catch (const std::exception &e) {
+                std::cout << "[ERR] " << e.what() << ".\n";
+                return;
+            }
+
+            if (m_options.soundSource == SoundSource::Speaker) {
+                m_umpk.setSpeakerListener(m_recorder.get());
+            }
+        }
+
+        _boot();
+
+        if (!m_options.programFile.empty() && !_loadProgram()) return;
+
+        m_umpk.getCpu().forceJump(m_options.startAddress);
+
+        _setupBreakpoints();
+
+        if (_run(m_options.cycles)) {
+            const Breakpoint *breakpoint =
+                m_umpk.getBreakpoints().find(m_umpk.getBreakpoints().stoppedBy());
+
+            std::cout << "[INFO] Stopped, "
+                      << Controller::breakpointHitToString(*breakpoint, m_umpk.getCpu()) << ".\n";
+        }
+
+        m_umpk.getBreakpoints().setListener(nullptr);
+
+        m_umpk.setSpeakerListener(nullptr);
+        m_umpk.getUsart().setHost(nullptr);
+        m_serial.reset();
+        m_printer.reset();
+        m_umpk.getAdc().setSource(nullptr);
+        m_adcSource.reset();
+        m_dacRecorder.reset();
+
+        if (m_recorder) m_recorder->finish(m_umpk.getCycles());
+
+        _report();
+
+        if (!m_options.benchExpression.empty()) _benchExpression(m_options.benchExpression);
+    }
+
+private:
+    const uint16_t PROGRAM_ADR    = 0x0800;
+    const uint16_t SOUND_FUNC_ADR = 0x0447;
+    const uint16_t START_END_ADR  = 0x00C5;
+
+    // The monitor is up well before this
+    const uint64_t BOOT_CYCLES_LIMIT = 50000000;
+
+    EmulatorOptions m_options;
+    Umpk80 m_umpk;
+    std::unique_ptr<WavRecorder> m_recorder;
+    std::unique_ptr<SerialStream> m_serial;
+    std::unique_ptr<PrinterCapture> m_printer;
+    std::unique_ptr<DacRecorder> m_dacRecorder;
+    std::unique_ptr<AnalogSource> m_adcSource;
+
+    bool _loadSystem() {
+        char os[0x800] = {0};
+
+        std::ifstream file(OS_FILE, std::ios::binary);
+        if (!file.is_open()) {
+            std::cout << "[ERR] Failed to open " << OS_FILE << ".\n";
+            return false;
+        }
+
+        file.read(os, 0x800);
+        file.close();
+
+        m_umpk.loadOS((const uint8_t *)os);
+        for (int i = 0; i < (int)HleRoutine::Count; i++) {
+            m_umpk.setHle((HleRoutine)i, m_options.hle[i]);
+        }
+
+        connectExpansionModules(m_umpk, m_options);
+
+        if (m_options.serialPort >= 0) {
+            try {
+                m_serial.reset(new SerialStream(m_options.serialIn, m_options.serialOut,
+                                                m_options.serialPty));
+            } catch (const std::exception &e) {
+                std::cout << "[ERR] " << e.what() << ".\n";
+                return false;
+            }
+
+            if (m_options.serialPty) {
+                std::cout << "[INFO] Serial line is on " << m_serial->ptyName() << "\n";
+            }
+
+            warnPortsTaken(m_umpk.setUsartPort(m_options.serialPort), "serial line",
+                           m_options.serialPort);
+            m_umpk.getUsart().setBaudRate(m_options.serialBaud);
+            m_umpk.getUsart().setInterrupt(m_options.serialRst);
+            m_umpk.getUsart().setHost(m_serial.get());
+        }
+
+        if (m_options.printerPort >= 0) {
+            try {
+                m_printer.reset(new PrinterCapture(m_umpk.getPrinter(), m_options.printerOut,
+                                                   m_options.printerPageLines));
+            } catch (const std::exception &e) {
+                std::cout << "[ERR] " << e.what() << ".\n";
+                return false;
+            }
+
+            warnPortsTaken(m_umpk.setPrinterPort(m_options.printerPort), "printer",
+                           m_options.printerPort);
+        }
+
+        try {
+            if (m_options.dacPort >= 0) {
+                m_dacRecorder.reset(new DacRecorder(m_umpk.getDac(), m_options.dacOut));
+                warnPortsTaken(m_umpk.setDacPort(m_options.dacPort), "DAC", m_options.dacPort);
+            }
+
+            if (m_options.adcPort >= 0) {
+                m_adcSource.reset(createAnalogSource(m_options.adcIn, m_options.adcRate,
+                                                     m_options.adcWave, UMPK80_CLOCK_HZ));
+                m_umpk.getAdc().setSource(m_adcSource.get());
+                warnPortsTaken(m_umpk.setAdcPort(m_options.adcPort), "ADC", m_options.adcPort);
+            }
+        } catch (const std::exception &e) {
+            std::cout << "[ERR] " << e.what() << ".\n";
+            return false;
+        }
+
+        return true;
+    }
+
+    void _boot() {
+        while (m_umpk.getCpu().getProgramCounter() != START_END_ADR &&
+               m_umpk.getCycles() < BOOT_CYCLES_LIMIT) {
+            m_umpk.tick();
+        }
+    }
+
+    bool _loadProgram() {
+        std::vector<uint8_t> program;
+
+        try {
+            program = Controller::readBinaryFile(m_options.programFile);
+        } catch (const std::exception &e) {
+            std::cout << "[ERR] " << e.what() << ".\n";
+            return false;
+        }
+
+        for (size_t i = 0; i < program.size(); i++) {
+            m_umpk.getBus().memoryWrite(PROGRAM_ADR + i, program[i]);
+        }
+
+        return true;
+    }
+
+    void _setupBreakpoints() {
+        for (const BreakpointOption &option : m_options.breakpoints) {
+            int id = m_umpk.getBreakpoints().add(option.address, option.condition.c_str(),
+                                                 option.hits, option.logOnly);
+
+            if (id == 0) {
+                std::cout << "[WARN] Breakpoint at " << std::hex << std::uppercase
+                          << option.address << std::dec << std::nouppercase
+                          << "h is not set, bad condition \"" << option.condition
+                          << "\" or too many breakpoints.\n";
+            }
+        }
+
+        m_umpk.getBreakpoints().setListener(this);
+    }
+
+    void breakpointLogged(const Breakpoint &breakpoint) override {
+        std::cout << "[INFO] " << Controller::breakpointHitToString(breakpoint, m_umpk.getCpu())
+                  << ".\n";
+    }
+
+    // True when a breakpoint stopped the run
+    bool _run(uint64_t cycles) {
+        // Without the sound hook there is nothing to check per instruction
+        // but the marks run() looks at
+        if (!m_recorder || m_options.soundSource != SoundSource::Hook) {
+            return m_umpk.run(cycles);
+        }
+
+        uint64_t target = m_umpk.getCycles() + cycles;
+        Cpu &cpu = m_umpk.getCpu();
+
+        bool stopped = false;
+
+        m_umpk.markAddress(SOUND_FUNC_ADR);
+
+        while (!stopped && m_umpk.getCycles() < target) {
+            m_umpk.tick();
+
+            uint16_t pc = cpu.getProgramCounter();
+
+            if (!m_umpk.isAddressMarked(pc)) continue;
+
+            if (pc == SOUND_FUNC_ADR) {
+                uint8_t duration = cpu.getRegister(Cpu::Register::D);
+                uint8_t frequency = 0xFF - cpu.getRegister(Cpu::Register::B);
+
+                // Same note as the live hook, placed at the current cycle
+                m_recorder->tone(m_umpk.getCycles(), frequency * 2, duration * 130);
+            }
+
+            stopped = m_umpk.getBreakpoints().check(pc);
+        }
+
+        m_umpk.unmarkAddress(SOUND_FUNC_ADR);
+
+        return stopped;
+    }
+
+    void _report() {
+        printf("Cycles:  %llu\n", (unsigned long long)m_umpk.getCycles());
+        printf("PC:      %04X\n", m_umpk.getCpu().getProgramCounter());
+        printf("Display:");
+
+        for (int i = 0; i < 6; i++) {
+            printf(" %02X", m_umpk.getDisplayDigit(i));
+        }
+
+        printf("\n");
+
+        if (m_umpk.getPpiPort() >= 0) {
+            Ppi8255 &ppi = m_umpk.getPpi();
+
+            printf("PPI:     A=%02X B=%02X C=%02X\n", ppi.getPins(PPI_PORT_A),
+                   ppi.getPins(PPI_PORT_B), ppi.getPins(PPI_PORT_C));
+        }
+
+        if (m_umpk.getPrinterPort() >= 0) {
+            Printer &printer = m_umpk.getPrinter();
+
+            printf("Printer: %llu bytes, %llu dropped\n",
+                   (unsigned long long)printer.printed(),
+                   (unsigned long long)printer.dropped());
+        }
+
+        if (m_umpk.getDacPort() >= 0) {
+            Dac &dac = m_umpk.getDac();
+
+            printf("DAC:     %llu writes, %llu dropped, last %02X\n",
+                   (unsigned long long)dac.writes(),
+                   (unsigned long long)dac.dropped(), dac.getValue());
+        }
+
+        CpuBusView view(m_umpk.getCpu(), m_umpk.getBus());
+
+        for (const std::string &text : m_options.watches) {
+            Expression watch;
+
+            if (!watch.compile(text.c_str())) {
+                printf("Watch:   %s - bad expression\n", text.c_str());
+                continue;
+            }
+
+            unsigned long long value = watch.evaluate(view);
+            printf("Watch:   %s = %llXh (%llu)\n", text.c_str(), value, value);
+        }
+    }
+
+    // Times compiling `text` and evaluating it on the final state
+    void _benchExpression(const std::string &text) {
+        const int COMPILES = 100000;
+        const int EVALUATIONS = 20000000;
+
+        Expression expression;
+        CpuBusView view(m_umpk.getCpu(), m_umpk.getBus());
+
+        if (!expression.compile(text.c_str())) {
+            std::cout << "[ERR] Bad expression \"" << text << "\".\n";
+            return;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < COMPILES; i++) expression.compile(text.c_str());
+
+        auto compiled = std::chrono::steady_clock::now();
+
+        // Summed so the evaluations can't be dropped
+        uint64_t sum = 0;
+        for (int i = 0; i < EVALUATIONS; i++) sum += expression.evaluate(view);
+
+        auto evaluated = std::chrono::steady_clock::now();
+
+        double compileNanos =
+            std::chrono::duration<double, std::nano>(compiled - start).count() / COMPILES;
+        double evaluateNanos =
+            std::chrono::duration<double, std::nano>(evaluated - compiled).count() / EVALUATIONS;
+
+        printf("Bench:   %s, %d bytes of bytecode, compiled in %.0f ns, "
+               "evaluated in %.2f ns (sum %llu)\n",
+               text.c_str(), expression.codeSize(), compileNanos, evaluateNanos,
+               (unsigned long long)sum);
+    }
+};
+
+#endif // UMPK_80_EMU_UI_HEADLESS_APP_HPP
@@ -0,0 +1,198 @@
+#include "host-stream.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <stdexcept>
+
+#include "host-thread.hpp"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#define read _read
+#define write _write
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+static const size_t BLOCK_SIZE = 4096;
+
+// How long the threads sleep or wait for input before checking for shutdown
+static const int IDLE_MS = 2;
+static const int POLL_MS = 50;
+
+void HostFile::open(const std::string& path, Mode mode) {
+    close();
+
+    if (path == "-") {
+        _fd = (mode == Mode::Read) ? 0 : 1;
+        _owned = false;
+        _name = (mode == Mode::Read) ? "stdin" : "stdout";
+        return;
+    }
+
+#ifdef _WIN32
+    int flags = _O_RDONLY | _O_BINARY;
+    if (mode == Mode::Write)  flags = _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY;
+    if (mode == Mode::Append) flags = _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY;
+    _fd = _open(path.c_str(), flags, 0644);
+#else
+    int flags = O_RDONLY;
+    if (mode == Mode::Write)  flags = O_WRONLY | O_CREAT | O_TRUNC;
+    if (mode == Mode::Append) flags = O_WRONLY | O_CREAT | O_APPEND;
+    _fd = ::open(path.c_str(), flags, 0644);
+#endif
+
+    if (_fd < 0) throw std::runtime_error("Failed to open " + path);
+
+    _owned = true;
+    _name = path;
+}
+
+void HostFile::openPty() {
+    close();
+
+#ifdef _WIN32
+    throw std::runtime_error("PTY is not supported on Windows");
+#else
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0) {
+        if (fd >= 0) ::close(fd);
+        throw std::runtime_error("Failed to open a PTY");
+    }
+
+    // Nobody may be attached to the slave yet, I/O must not block on it
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    _fd = fd;
+    _owned = true;
+    _name = ptsname(fd);
+#endif
+}
+
+void HostFile::close() {
+    if (_fd < 0) return;
+
+#ifdef _WIN32
+    if (_owned) _close(_fd);
+#else
+    if (_owned) ::close(_fd);
+#endif
+
+    _fd = -1;
+    _owned = false;
+    _name.clear();
+}
+
+size_t HostFile::writeBlock(const uint8_t* data, size_t size) {
+    size_t done = 0;
+
+    while (done < size) {
+        int n = (int)write(_fd, data + done, (unsigned)(size - done));
+
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+
+        done += n;
+    }
+
+    return done;
+}
+
+HostStreamWriter::HostStreamWriter(HostFile& file)
+    : _file(file), _thread(&HostStreamWriter::_work, this) {}
+
+HostStreamWriter::~HostStreamWriter() {
+    _running.store(false, std::memory_order_release);
+    _thread.join();
+}
+
+bool HostStreamWriter::put(uint8_t byte) {
+    if (_ring.push(byte)) return true;
+
+    _dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void HostStreamWriter::_work() {
+    setHostThreadName("umpk-host-out");
+
+    uint8_t block[BLOCK_SIZE];
+
+    for (;;) {
+        // Checked before draining, so everything queued before the
+        // destructor ran is still written
+        bool running = _running.load(std::memory_order_acquire);
+
+        size_t size = 0;
+        while (size < BLOCK_SIZE && _ring.pop(block[size])) size++;
+
+        for (size_t done = 0; done < size;) {
+            int n = (int)write(_file.fd(), block + done, (unsigned)(size - done));
+
+            if (n > 0) {
+                done += n;
+                continue;
+            }
+
+            // Full pipe or PTY: retry until shutdown, then give up
+            if (n < 0 && errno == EAGAIN && _running.load(std::memory_order_acquire)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(IDLE_MS));
+                continue;
+            }
+
+            break;
+        }
+
+        if (size == 0) {
+            if (!running) return;
+            std::this_thread::sleep_for(std::chrono::milliseconds(IDLE_MS));
+        }
+    }
+}
+
+HostStreamReader::HostStreamReader(HostFile& file)
+    : _file(file), _thread(&HostStreamReader::_work, this) {}
+
+HostStreamReader::~HostStreamReader() {
+    _running.store(false, std::memory_order_release);
+    _thread.join();
+}
+
+void HostStreamReader::_work() {
+    setHostThreadName("umpk-host-in");
+
+    uint8_t block[256];
+
+    while (_running.load(std::memory_order_acquire)) {
+        // Only read what fits, so a slow guest applies back pressure
+        if (_ring.capacity() - _ring.size() < sizeof(block)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(IDLE_MS));
+            continue;
+        }
+
+#ifndef _WIN32
+        pollfd pfd = {_file.fd(), POLLIN, 0};
+        if (poll(&pfd, 1, POLL_MS) <= 0) continue;
+#endif
+
+        int n = (int)read(_file.fd(), block, sizeof(block));
+
+        // PTY without a peer yet
+        if (n < 0 && (errno == EAGAIN || errno == EIO)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(POLL_MS));
+            continue;
+        }
+
+        if (n <= 0) {
+            _eof.store(true, std::memory_order_release);
+            return;
+        }
+
+        for (int i = 0; i < n; i++) _ring.push(block[i]);
+    }
+}
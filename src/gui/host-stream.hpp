@@ -0,0 +1,93 @@
+#ifndef UMPK_80_EMU_UI_HOST_STREAM_HPP
+#define UMPK_80_EMU_UI_HOST_STREAM_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "../core/ring.hpp"
+
+// Host file descriptor: a file, a pipe, stdin/stdout ("-") or a PTY.
+// Throws std::runtime_error when it can't be opened.
+class HostFile {
+public:
+    // Write truncates the file, Append adds to its end
+    enum class Mode { Read, Write, Append };
+
+    HostFile() {}
+    HostFile(const std::string& path, Mode mode) { open(path, mode); }
+    ~HostFile() { close(); }
+
+    HostFile(const HostFile&) = delete;
+    HostFile& operator=(const HostFile&) = delete;
+
+    void open(const std::string& path, Mode mode);
+
+    // Opens a pseudo-terminal master, name() is the slave to connect to.
+    // Not available on Windows.
+    void openPty();
+
+    void close();
+
+    // Blocking write of the whole block, returns how much was written
+    // before an error. For files and pipes, not for non-blocking PTYs.
+    size_t writeBlock(const uint8_t* data, size_t size);
+
+    bool isOpen() const { return _fd >= 0; }
+    int fd() const { return _fd; }
+    const std::string& name() const { return _name; }
+
+private:
+    int _fd = -1;
+    bool _owned = false;
+    std::string _name;
+};
+
+// Never blocks the caller: bytes go through a lock-free ring to a thread
+// that writes them out in blocks.
+class HostStreamWriter {
+public:
+    // `file` must outlive the writer
+    HostStreamWriter(HostFile& file);
+    ~HostStreamWriter();
+
+    // Emulation thread, false (and the byte is counted as dropped)
+    // when the ring is full
+    bool put(uint8_t byte);
+
+    uint64_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+    HostFile& _file;
+    SpscRing<uint8_t, 0x10000> _ring;
+    std::atomic<bool> _running{true};
+    std::atomic<uint64_t> _dropped{0};
+    std::thread _thread;
+
+    void _work();
+};
+
+// Reads the host stream ahead on a thread, get() never blocks
+class HostStreamReader {
+public:
+    // `file` must outlive the reader
+    HostStreamReader(HostFile& file);
+    ~HostStreamReader();
+
+    // Emulation thread, false when nothing has arrived yet
+    bool get(uint8_t& byte) { return _ring.pop(byte); }
+
+    bool isEof() const { return _eof.load(std::memory_order_acquire) && _ring.empty(); }
+
+private:
+    HostFile& _file;
+    SpscRing<uint8_t, 0x1000> _ring;
+    std::atomic<bool> _running{true};
+    std::atomic<bool> _eof{false};
+    std::thread _thread;
+
+    void _work();
+};
+
+#endif // UMPK_80_EMU_UI_HOST_STREAM_HPP
@@ -0,0 +1,136 @@
+#include "host-thread.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static HostThreadSettings g_settings[3];
+
+static const char* threadRoleName(HostThread thread) {
+    switch (thread) {
+    case HostThread::Emulation: return "Emulation";
+    case HostThread::Audio:     return "Audio";
+    default:                    return "Render";
+    }
+}
+
+bool parseThreadPolicy(const std::string& spec, HostThreadSettings& settings) {
+    size_t colon = spec.find(':');
+    std::string name = spec.substr(0, colon);
+    bool hasValue = colon != std::string::npos;
+    int value = hasValue ? std::atoi(spec.c_str() + colon + 1) : 0;
+
+    if (name == "fifo") {
+        if (!hasValue) value = 50;
+        if (value < 1 || value > 99) return false;
+
+        settings.policy = HostThreadSettings::Policy::Fifo;
+    } else if (name == "nice" && hasValue) {
+        if (value < -20 || value > 19) return false;
+
+        settings.policy = HostThreadSettings::Policy::Nice;
+    } else {
+        return false;
+    }
+
+    settings.priority = value;
+
+    return true;
+}
+
+void setHostThreadSettings(HostThread thread, const HostThreadSettings& settings) {
+    g_settings[(int)thread] = settings;
+}
+
+void setHostThreadName(const char* name) {
+#if defined(__linux__)
+    char shortName[16];
+    strncpy(shortName, name, sizeof(shortName) - 1);
+    shortName[sizeof(shortName) - 1] = 0;
+
+    pthread_setname_np(pthread_self(), shortName);
+#elif defined(__APPLE__)
+    pthread_setname_np(name);
+#else
+    (void)name;
+#endif
+}
+
+static void pinThread(const char* role, int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+
+    if (error != 0) {
+        std::cout << "[WARN] " << role << " thread can't be pinned to CPU " << cpu << ": "
+                  << strerror(error) << ".\n";
+    } else {
+        std::cout << "[INFO] " << role << " thread is pinned to CPU " << cpu << ".\n";
+    }
+#else
+    std::cout << "[WARN] Pinning threads is not supported on this host, " << role
+              << " thread runs on any CPU.\n";
+#endif
+}
+
+static void prioritizeThread(const char* role, const HostThreadSettings& settings) {
+#ifdef _WIN32
+    std::cout << "[WARN] Thread priorities are not supported on this host, " << role
+              << " thread keeps the default one.\n";
+#else
+    if (settings.policy == HostThreadSettings::Policy::Fifo) {
+        sched_param param;
+        param.sched_priority = settings.priority;
+
+        int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+
+        if (error != 0) {
+            std::cout << "[WARN] " << role << " thread can't use SCHED_FIFO: " << strerror(error)
+                      << " (needs CAP_SYS_NICE or an rtprio limit).\n";
+        } else {
+            std::cout << "[INFO] " << role << " thread runs SCHED_FIFO at priority "
+                      << settings.priority << ".\n";
+        }
+        return;
+    }
+
+#ifdef __linux__
+    // Linux keeps a nice level per thread
+    if (setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), settings.priority) != 0) {
+        std::cout << "[WARN] " << role << " thread can't be set to nice " << settings.priority
+                  << ": " << strerror(errno) << ".\n";
+    } else {
+        std::cout << "[INFO] " << role << " thread runs at nice " << settings.priority << ".\n";
+    }
+#else
+    std::cout << "[WARN] Per-thread nice levels are not supported on this host, " << role
+              << " thread keeps the default one.\n";
+#endif
+#endif
+}
+
+void configureHostThread(HostThread thread, const char* name) {
+    const HostThreadSettings& settings = g_settings[(int)thread];
+    const char* role = threadRoleName(thread);
+
+    if (name != nullptr) setHostThreadName(name);
+
+    if (settings.cpu >= 0) pinThread(role, settings.cpu);
+
+    if (settings.policy != HostThreadSettings::Policy::Default) prioritizeThread(role, settings);
+}
@@ -0,0 +1,36 @@
+#ifndef UMPK_80_EMU_UI_HOST_THREAD_HPP
+#define UMPK_80_EMU_UI_HOST_THREAD_HPP
+
+#include <string>
+
+// Where and how a host thread is scheduled
+struct HostThreadSettings {
+    enum class Policy { Default, Fifo, Nice };
+
+    // Core the thread is pinned to, -1 - any
+    int cpu = -1;
+
+    Policy policy = Policy::Default;
+    // SCHED_FIFO priority (1-99) or nice level (-20-19)
+    int priority = 0;
+};
+
+enum class HostThread { Emulation, Audio, Render };
+
+// "fifo[:<priority>]" (50 by default) or "nice:<level>",
+// false on a bad spec
+bool parseThreadPolicy(const std::string& spec, HostThreadSettings& settings);
+
+// Settings configureHostThread applies. Set them at startup, before
+// the threads are started.
+void setHostThreadSettings(HostThread thread, const HostThreadSettings& settings);
+
+// Names the calling thread (nullptr keeps the name) and applies the
+// settings of `thread` to it. What the host doesn't support or allow
+// is reported and skipped.
+void configureHostThread(HostThread thread, const char* name);
+
+// Name shown by top and perf, at most 15 characters
+void setHostThreadName(const char* name);
+
+#endif // UMPK_80_EMU_UI_HOST_THREAD_HPP
@@ -1,5 +1,7 @@
 #include "gui-app.hpp"
 #include "gui-app-compact.hpp"
+#include "headless-app.hpp"
+#include "emulator-options.hpp"
 #include <cstdint>
 
 enum {
@@ -61,12 +63,21 @@ int main(int argc, char* argv[]) {
 #ifdef DEBUG
     runTestDAA();
 #endif
+    EmulatorOptions options = parseEmulatorOptions(argc, argv);
+
+    // Before any thread is started, each one applies its own
+    setHostThreadSettings(HostThread::Emulation, options.emuThread);
+    setHostThreadSettings(HostThread::Audio, options.audioThread);
+    setHostThreadSettings(HostThread::Render, options.renderThread);
+
     GuiAppBase* app = nullptr;
 
-    if (argc > 1) {
-        app = new GuiAppCompact(argv[1]);
+    if (options.headless) {
+        app = new HeadlessApp(options);
+    } else if (!options.programFile.empty()) {
+        app = new GuiAppCompact(options);
     } else {
-        app = new GuiApp();
+        app = new GuiApp(options);
     }
 
     app->start();
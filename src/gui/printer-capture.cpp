@@ -0,0 +1,124 @@
+#include "printer-capture.hpp"
+
+#include <chrono>
+
+#include "host-thread.hpp"
+
+static const size_t BLOCK_SIZE = 4096;
+
+// How long the thread sleeps on an empty printer before looking again
+static const int IDLE_MS = 2;
+
+PrinterCapture::PrinterCapture(Printer& printer, const std::string& outPath,
+                               uint32_t linesPerPage)
+    : _printer(printer), _linesPerPage(linesPerPage ? linesPerPage : 1) {
+    if (!outPath.empty()) _file.open(outPath, HostFile::Mode::Append);
+
+    _pages.emplace_back();
+
+    // Started last, it uses everything above
+    _thread = std::thread(&PrinterCapture::_work, this);
+}
+
+PrinterCapture::~PrinterCapture() {
+    _running.store(false, std::memory_order_release);
+    _thread.join();
+}
+
+size_t PrinterCapture::pageCount() {
+    std::lock_guard<std::mutex> lock(_paperMutex);
+
+    return _firstPage + _pages.size();
+}
+
+bool PrinterCapture::getPage(size_t number, std::vector<std::string>& lines) {
+    std::lock_guard<std::mutex> lock(_paperMutex);
+
+    if (number < _firstPage || number >= _firstPage + _pages.size()) return false;
+
+    lines = _pages[number - _firstPage];
+
+    if (number == _firstPage + _pages.size() - 1 && !_line.empty()) lines.push_back(_line);
+
+    return true;
+}
+
+void PrinterCapture::_work() {
+    setHostThreadName("umpk-printer");
+
+    uint8_t block[BLOCK_SIZE];
+
+    for (;;) {
+        // Checked before draining, so everything printed before the
+        // destructor ran still gets out
+        bool running = _running.load(std::memory_order_acquire);
+
+        size_t size = 0;
+        while (size < BLOCK_SIZE && _printer.take(block[size])) size++;
+
+        if (size == 0) {
+            if (!running) return;
+            std::this_thread::sleep_for(std::chrono::milliseconds(IDLE_MS));
+            continue;
+        }
+
+        if (_file.isOpen()) _file.writeBlock(block, size);
+
+        _bytes.fetch_add(size, std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(_paperMutex);
+        for (size_t i = 0; i < size; i++) _feed(block[i]);
+    }
+}
+
+void PrinterCapture::_feed(uint8_t byte) {
+    bool afterCr = _afterCr;
+    _afterCr = false;
+
+    switch (byte) {
+    case '\r':
+        _afterCr = true;
+        _endLine();
+        return;
+
+    case '\n':
+        // Second half of CRLF
+        if (!afterCr) _endLine();
+        return;
+
+    case '\f':
+        if (!_line.empty()) _endLine();
+        _newPage();
+        return;
+
+    case '\t':
+        do _line.push_back(' '); while (_line.size() % 8 != 0 && _line.size() < PAGE_COLUMNS);
+        break;
+
+    default:
+        // Other control codes don't print, 8-bit codes have no glyphs
+        // in the GUI font
+        if (byte < 0x20 || byte == 0x7F) return;
+
+        _line.push_back(byte < 0x80 ? (char)byte : '?');
+        break;
+    }
+
+    if (_line.size() >= PAGE_COLUMNS) _endLine();
+}
+
+void PrinterCapture::_endLine() {
+    if (_pages.back().size() >= _linesPerPage) _newPage();
+
+    _pages.back().push_back(_line);
+    _line.clear();
+}
+
+void PrinterCapture::_newPage() {
+    _pages.emplace_back();
+
+    if (_pages.size() > MAX_PAGES) {
+        _pages.pop_front();
+        _firstPage++;
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef UMPK_80_EMU_UI_PRINTER_CAPTURE_HPP
+#define UMPK_80_EMU_UI_PRINTER_CAPTURE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../core/printer.hpp"
+
+#include "host-stream.hpp"
+
+// Drains the printer on a background thread: the bytes are appended
+// as they are to a file and cut into lines and pages for the GUI.
+// Lines end with CR, LF or CRLF and wrap at PAGE_COLUMNS, pages end with
+// a form feed or after `linesPerPage` lines.
+class PrinterCapture {
+public:
+    static const size_t PAGE_COLUMNS = 80;
+
+    // `printer` must outlive the capture. An empty `outPath` only keeps
+    // the paper in memory, "-" prints to stdout.
+    // Throws std::runtime_error if the file can't be opened.
+    PrinterCapture(Printer& printer, const std::string& outPath, uint32_t linesPerPage);
+
+    // Whatever the printer still holds is written out first
+    ~PrinterCapture();
+
+    uint64_t bytes() const { return _bytes.load(std::memory_order_relaxed); }
+
+    // Pages started so far, the last one is still being printed
+    size_t pageCount();
+
+    // Copies the lines of page `number` (from 0), including the line
+    // being printed. False when the page was discarded to bound memory.
+    bool getPage(size_t number, std::vector<std::string>& lines);
+
+    const std::string& fileName() const { return _file.name(); }
+
+private:
+    // Oldest pages are dropped past this, the file keeps everything
+    static const size_t MAX_PAGES = 500;
+
+    Printer& _printer;
+    HostFile _file;
+    uint32_t _linesPerPage;
+
+    std::mutex _paperMutex;
+    std::deque<std::vector<std::string>> _pages;
+    size_t _firstPage = 0;
+    std::string _line;
+    bool _afterCr = false;
+
+    std::atomic<uint64_t> _bytes{0};
+    std::atomic<bool> _running{true};
+    std::thread _thread;
+
+    void _work();
+    void _feed(uint8_t byte);
+    void _endLine();
+    void _newPage();
+};
+
+#endif // UMPK_80_EMU_UI_PRINTER_CAPTURE_HPP
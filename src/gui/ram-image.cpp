@@ -0,0 +1,111 @@
+#include "ram-image.hpp"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+void RamImage::open(const std::string& path, size_t size) {
+    close();
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                              OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Failed to open RAM image " + path);
+    }
+
+    // The mapping grows a shorter file up to `size` with zeroes
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, 0,
+                                        (DWORD)size, NULL);
+    if (mapping == NULL) {
+        CloseHandle(file);
+        throw std::runtime_error("Failed to map RAM image " + path);
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (view == NULL) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        throw std::runtime_error("Failed to map RAM image " + path);
+    }
+
+    _file = file;
+    _mapping = mapping;
+    _data = (uint8_t*)view;
+    _size = size;
+}
+
+void RamImage::close() {
+    if (_data == nullptr) return;
+
+    FlushViewOfFile(_data, _size);
+    UnmapViewOfFile(_data);
+    FlushFileBuffers((HANDLE)_file);
+    CloseHandle((HANDLE)_mapping);
+    CloseHandle((HANDLE)_file);
+
+    _data = nullptr;
+    _mapping = nullptr;
+    _file = nullptr;
+    _size = 0;
+}
+
+void RamImage::flush() {
+    // Only starts the write-back, the lazy writer does the rest
+    if (_data != nullptr) FlushViewOfFile(_data, _size);
+}
+
+#else
+
+void RamImage::open(const std::string& path, size_t size) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open RAM image " + path);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        ((size_t)st.st_size < size && ftruncate(fd, size) != 0)) {
+        ::close(fd);
+        throw std::runtime_error("Failed to resize RAM image " + path);
+    }
+
+    void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED) {
+        ::close(fd);
+        throw std::runtime_error("Failed to map RAM image " + path);
+    }
+
+    _fd = fd;
+    _data = (uint8_t*)view;
+    _size = size;
+}
+
+void RamImage::close() {
+    if (_data == nullptr) return;
+
+    msync(_data, _size, MS_SYNC);
+    munmap(_data, _size);
+    ::close(_fd);
+
+    _data = nullptr;
+    _fd = -1;
+    _size = 0;
+}
+
+void RamImage::flush() {
+    if (_data != nullptr) msync(_data, _size, MS_ASYNC);
+}
+
+#endif
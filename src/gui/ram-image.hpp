@@ -0,0 +1,46 @@
+#ifndef UMPK_80_EMU_UI_RAM_IMAGE_HPP
+#define UMPK_80_EMU_UI_RAM_IMAGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// File mapped into memory that backs the emulated address space.
+// The file layout matches the guest address space: offset == address,
+// so external tools can inspect RAM at offsets 0x0800-0x0FFF directly.
+class RamImage {
+public:
+    RamImage() {}
+    ~RamImage() { close(); }
+
+    RamImage(const RamImage&) = delete;
+    RamImage& operator=(const RamImage&) = delete;
+
+    // Opens (or creates) the image file and maps `size` bytes of it.
+    // Throws std::runtime_error on failure.
+    void open(const std::string& path, size_t size);
+
+    // Synchronously writes everything back and unmaps the file.
+    void close();
+
+    // Schedules dirty pages for write-back without waiting for the disk.
+    void flush();
+
+    bool isOpen() const { return _data != nullptr; }
+
+    uint8_t* data() { return _data; }
+    size_t size() const { return _size; }
+
+private:
+    uint8_t* _data = nullptr;
+    size_t _size = 0;
+
+#ifdef _WIN32
+    void* _file = nullptr;
+    void* _mapping = nullptr;
+#else
+    int _fd = -1;
+#endif
+};
+
+#endif // UMPK_80_EMU_UI_RAM_IMAGE_HPP
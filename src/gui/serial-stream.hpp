@@ -0,0 +1,63 @@
+#ifndef UMPK_80_EMU_UI_SERIAL_STREAM_HPP
+#define UMPK_80_EMU_UI_SERIAL_STREAM_HPP
+
+#include <memory>
+#include <string>
+
+#include "../core/usart8251.hpp"
+
+#include "host-stream.hpp"
+
+// Connects the USART to host streams: transmitted bytes are written to
+// `outPath`, received bytes are read from `inPath` ("-" for stdin/stdout,
+// empty leaves the direction unconnected). With `pty` both directions go
+// through a new pseudo-terminal instead.
+// Throws std::runtime_error if a stream can't be opened.
+class SerialStream : public SerialHost {
+public:
+    SerialStream(const std::string& inPath, const std::string& outPath, bool pty) {
+        if (pty) {
+            _pty.openPty();
+            _writer.reset(new HostStreamWriter(_pty));
+            _reader.reset(new HostStreamReader(_pty));
+            return;
+        }
+
+        if (!outPath.empty()) {
+            _out.open(outPath, HostFile::Mode::Write);
+            _writer.reset(new HostStreamWriter(_out));
+        }
+
+        if (!inPath.empty()) {
+            _in.open(inPath, HostFile::Mode::Read);
+            _reader.reset(new HostStreamReader(_in));
+        }
+    }
+
+    ~SerialStream() {
+        // Threads go first, they use the files
+        _writer.reset();
+        _reader.reset();
+    }
+
+    void serialTransmit(u64, u8 data) override {
+        if (_writer) _writer->put(data);
+    }
+
+    bool serialReceive(u8& data) override {
+        return _reader && _reader->get(data);
+    }
+
+    // Slave device to connect a terminal to, empty without a PTY
+    const std::string& ptyName() const { return _pty.name(); }
+
+private:
+    HostFile _in;
+    HostFile _out;
+    HostFile _pty;
+
+    std::unique_ptr<HostStreamWriter> _writer;
+    std::unique_ptr<HostStreamReader> _reader;
+};
+
+#endif // UMPK_80_EMU_UI_SERIAL_STREAM_HPP
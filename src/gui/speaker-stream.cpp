@@ -0,0 +1,96 @@
+#include "speaker-stream.hpp"
+
+#include "host-thread.hpp"
+
+// One-pole high-pass that removes the DC offset of the square wave
+static const double DC_BLOCKER_POLE = 0.995;
+static const double AMPLITUDE = 6000.0;
+
+// Edges further than this from the playback cursor (in chunks)
+// mean emulation and playback drifted apart
+static const double MAX_DRIFT_CHUNKS = 4.0;
+
+SpeakerStream::SpeakerStream(u32 clockHz)
+    : _cyclesPerSample((double)clockHz / SAMPLE_RATE) {
+    initialize(1, SAMPLE_RATE);
+}
+
+SpeakerStream::~SpeakerStream() {
+    stop();
+}
+
+void SpeakerStream::speakerLevel(u64 cycle, bool level) {
+    // Never blocks, a full ring just loses the edge
+    _edges.push({cycle, level});
+}
+
+bool SpeakerStream::onGetData(Chunk& data) {
+    if (!_threadSetUp) {
+        configureHostThread(HostThread::Audio, "umpk-speaker");
+        _threadSetUp = true;
+    }
+
+    _resync();
+
+    for (u32 i = 0; i < CHUNK_SAMPLES; i++) {
+        double from = _cursor;
+        double to   = _cursor + _cyclesPerSample;
+
+        // Box-filtered square wave: the fraction of the sample period
+        // the speaker was high, instead of point sampling it
+        double x = _integrate(from, to) * 2.0 - 1.0;
+
+        _dcOut = x - _dcIn + DC_BLOCKER_POLE * _dcOut;
+        _dcIn  = x;
+
+        _samples[i] = (sf::Int16)(_dcOut * AMPLITUDE);
+        _cursor = to;
+    }
+
+    data.samples = _samples;
+    data.sampleCount = CHUNK_SAMPLES;
+
+    return true;
+}
+
+void SpeakerStream::_resync() {
+    Edge edge;
+
+    // Emulation outruns playback, drop the backlog
+    while (_edges.size() > _edges.capacity() / 2 && _edges.pop(edge)) {
+        _level  = edge.level;
+        _cursor = (double)edge.cycle;
+    }
+
+    if (!_edges.peek(edge)) return;
+
+    double chunk = CHUNK_SAMPLES * _cyclesPerSample;
+    double lead  = (double)edge.cycle - _cursor;
+
+    // First edge, resume after a pause or a big drift: restart playback
+    // one chunk before the edge
+    if (!_synced || lead > MAX_DRIFT_CHUNKS * chunk || lead < -MAX_DRIFT_CHUNKS * chunk) {
+        _cursor = (double)edge.cycle - chunk;
+        _synced = true;
+    }
+}
+
+double SpeakerStream::_integrate(double from, double to) {
+    double high = 0;
+    double t = from;
+    Edge edge;
+
+    while (_edges.peek(edge) && (double)edge.cycle < to) {
+        if ((double)edge.cycle > t) {
+            if (_level) high += (double)edge.cycle - t;
+            t = (double)edge.cycle;
+        }
+
+        _level = edge.level;
+        _edges.pop(edge);
+    }
+
+    if (_level) high += to - t;
+
+    return high / (to - from);
+}
@@ -0,0 +1,49 @@
+#ifndef UMPK_80_EMU_UI_SPEAKER_STREAM_HPP
+#define UMPK_80_EMU_UI_SPEAKER_STREAM_HPP
+
+#include <SFML/Audio.hpp>
+
+#include "../core/ring.hpp"
+#include "../core/speaker.hpp"
+
+// Turns cycle-stamped speaker level changes into PCM.
+// The emulation thread only pushes edges into a lock-free ring,
+// the samples are synthesized on the SFML audio thread.
+class SpeakerStream : public sf::SoundStream, public SpeakerListener {
+public:
+    static const unsigned SAMPLE_RATE = 44100;
+
+    SpeakerStream(u32 clockHz);
+    ~SpeakerStream();
+
+    // Emulation thread
+    void speakerLevel(u64 cycle, bool level) override;
+
+private:
+    struct Edge {
+        u64 cycle;
+        bool level;
+    };
+
+    static const u32 CHUNK_SAMPLES = 1024;
+
+    SpscRing<Edge, 8192> _edges;
+
+    // Audio thread state
+    bool   _threadSetUp = false;
+    sf::Int16 _samples[CHUNK_SAMPLES];
+    double _cyclesPerSample;
+    double _cursor = 0;
+    bool   _synced = false;
+    bool   _level = false;
+    double _dcIn = 0;
+    double _dcOut = 0;
+
+    bool onGetData(Chunk& data) override;
+    void onSeek(sf::Time) override {}
+
+    void _resync();
+    double _integrate(double from, double to);
+};
+
+#endif // UMPK_80_EMU_UI_SPEAKER_STREAM_HPP
@@ -0,0 +1,130 @@
+#include "wav-recorder.hpp"
+
+#include <stdexcept>
+
+static const size_t BUFFER_BYTES = 1 << 16;
+static const double DC_BLOCKER_POLE = 0.995;
+static const double AMPLITUDE = 12000.0;
+
+WavRecorder::WavRecorder(const std::string& path, uint32_t clockHz)
+    : _file(path, std::ios::binary | std::ios::trunc),
+      _cyclesPerSample((double)clockHz / SAMPLE_RATE) {
+    if (!_file.is_open()) {
+        throw std::runtime_error("Failed to create WAV file " + path);
+    }
+
+    _buffer.reserve(BUFFER_BYTES);
+
+    // Sizes are patched when the recording is finished
+    _writeHeader();
+}
+
+WavRecorder::~WavRecorder() {
+    if (_file.is_open()) finish((u64)_time);
+}
+
+void WavRecorder::speakerLevel(u64 cycle, bool level) {
+    _advanceTo(cycle);
+    _level = level;
+}
+
+void WavRecorder::tone(u64 cycle, double freq, int samples) {
+    _advanceTo(cycle);
+
+    // Close the partially rendered sample first
+    _advanceTo((u64)((_samplesWritten + 1) * _cyclesPerSample));
+
+    int tpc = (freq > 0) ? (int)(SAMPLE_RATE / freq) : 0;
+
+    for (int i = 0; i < samples; i++) {
+        _emit((tpc > 0 && (i % tpc) < tpc / 2) ? 1.0 : -1.0);
+    }
+
+    _time = _samplesWritten * _cyclesPerSample;
+    _high = 0;
+}
+
+void WavRecorder::finish(u64 cycle) {
+    if (!_file.is_open()) return;
+
+    _advanceTo(cycle);
+    _flush();
+
+    _file.seekp(0);
+    _writeHeader();
+    _file.close();
+}
+
+void WavRecorder::_advanceTo(u64 cycle) {
+    double c = (double)cycle;
+
+    for (;;) {
+        double end = (_samplesWritten + 1) * _cyclesPerSample;
+
+        if (c < end) {
+            if (c > _time) {
+                if (_level) _high += c - _time;
+                _time = c;
+            }
+            return;
+        }
+
+        if (_level && end > _time) _high += end - _time;
+
+        // Box-filtered like the live speaker stream
+        _emit(_high / _cyclesPerSample * 2.0 - 1.0);
+
+        _high = 0;
+        _time = end;
+    }
+}
+
+void WavRecorder::_emit(double x) {
+    _dcOut = x - _dcIn + DC_BLOCKER_POLE * _dcOut;
+    _dcIn  = x;
+
+    double v = _dcOut * AMPLITUDE;
+    if (v > 32767)  v = 32767;
+    if (v < -32768) v = -32768;
+
+    _write((int16_t)v);
+    _samplesWritten++;
+}
+
+void WavRecorder::_write(int16_t sample) {
+    _buffer.push_back((char)(sample & 0xFF));
+    _buffer.push_back((char)((sample >> 8) & 0xFF));
+
+    if (_buffer.size() >= BUFFER_BYTES) _flush();
+}
+
+void WavRecorder::_flush() {
+    _file.write(_buffer.data(), _buffer.size());
+    _buffer.clear();
+}
+
+static void putLE(std::ofstream& file, uint32_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        file.put((char)((value >> (i * 8)) & 0xFF));
+    }
+}
+
+void WavRecorder::_writeHeader() {
+    uint32_t dataSize = (uint32_t)(_samplesWritten * 2);
+
+    _file.write("RIFF", 4);
+    putLE(_file, 36 + dataSize, 4);
+    _file.write("WAVE", 4);
+
+    _file.write("fmt ", 4);
+    putLE(_file, 16, 4);              // Chunk size
+    putLE(_file, 1, 2);               // PCM
+    putLE(_file, 1, 2);               // Mono
+    putLE(_file, SAMPLE_RATE, 4);
+    putLE(_file, SAMPLE_RATE * 2, 4); // Byte rate
+    putLE(_file, 2, 2);               // Block align
+    putLE(_file, 16, 2);              // Bits per sample
+
+    _file.write("data", 4);
+    putLE(_file, dataSize, 4);
+}
@@ -0,0 +1,51 @@
+#ifndef UMPK_80_EMU_UI_WAV_RECORDER_HPP
+#define UMPK_80_EMU_UI_WAV_RECORDER_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../core/speaker.hpp"
+
+// Renders speaker activity into a 16-bit mono WAV file offline.
+// Samples are placed by emulated cycle timestamps, so a run is written
+// as fast as it is emulated and no audio device is needed.
+class WavRecorder : public SpeakerListener {
+public:
+    static const uint32_t SAMPLE_RATE = 44100;
+
+    // Throws std::runtime_error if the file can't be created
+    WavRecorder(const std::string& path, uint32_t clockHz);
+    ~WavRecorder();
+
+    // Level change of the speaker port
+    void speakerLevel(u64 cycle, bool level) override;
+
+    // Note of the monitor's sound subroutine, `samples` long
+    void tone(u64 cycle, double freq, int samples);
+
+    // Renders up to `cycle`, patches the header and closes the file
+    void finish(u64 cycle);
+
+private:
+    std::ofstream _file;
+    std::vector<char> _buffer;
+
+    double   _cyclesPerSample;
+    uint64_t _samplesWritten = 0;
+
+    bool   _level = false;
+    double _time = 0;       // Cycle the timeline is rendered up to
+    double _high = 0;       // Cycles the speaker was high in the current sample
+    double _dcIn = 0;
+    double _dcOut = 0;
+
+    void _advanceTo(u64 cycle);
+    void _emit(double x);
+    void _write(int16_t sample);
+    void _flush();
+    void _writeHeader();
+};
+
+#endif // UMPK_80_EMU_UI_WAV_RECORDER_HPP